@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<bool> s_countAllocations = false;
+static std::atomic<int> s_allocations = 0;
+static std::atomic<qint64> s_bytes = 0;
+
+static void countAllocation(std::size_t size)
+{
+    if (s_countAllocations.load(std::memory_order_relaxed)) {
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+        s_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+#if defined(__GLIBC__)
+// Qt's containers, QString and QRegion allocate with malloc and realloc instead of operator new.
+// glibc exports its allocator under these names, so the test can replace the public functions.
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(std::size_t size) __THROW
+{
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size) __THROW
+{
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, std::size_t size) __THROW
+{
+    countAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) __THROW
+{
+    __libc_free(ptr);
+}
+}
+
+static void *allocate(std::size_t size)
+{
+    return __libc_malloc(size);
+}
+#else
+static void *allocate(std::size_t size)
+{
+    return std::malloc(size);
+}
+#endif
+
+void *operator new(std::size_t size)
+{
+    countAllocation(size);
+    if (void *ptr = allocate(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+AllocationCounter::AllocationCounter()
+{
+    s_allocations = 0;
+    s_bytes = 0;
+    s_countAllocations = true;
+}
+
+AllocationCounter::~AllocationCounter()
+{
+    s_countAllocations = false;
+}
+
+int AllocationCounter::allocations() const
+{
+    return s_allocations;
+}
+
+qint64 AllocationCounter::bytes() const
+{
+    return s_bytes;
+}
@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#pragma once
+
+#include <QtGlobal>
+
+/**
+ * Counts the heap allocations done while an AllocationCounter exists. Linking allocationcounter.cpp
+ * replaces the global operator new of the test and with glibc also malloc, calloc and realloc, so
+ * the allocations of Qt's containers get counted as well. Other C libraries only count operator new.
+ **/
+class AllocationCounter
+{
+public:
+    AllocationCounter();
+    ~AllocationCounter();
+
+    int allocations() const;
+    qint64 bytes() const;
+};
@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#include "../src/decorationbuttongroup.h"
+#include "../src/decorationsettings.h"
+#include "../src/decorationshadow.h"
+#include "allocationcounter.h"
+#include "mockbridge.h"
+#include "mockbutton.h"
+#include "mockdecoration.h"
+#include "mockwindow.h"
+#include <QTest>
+
+#include <memory>
+#include <vector>
+
+class DecorationBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchmarkCreate();
+    void benchmarkHoverMove();
+    void benchmarkPressRelease();
+    void benchmarkButtonGroupLayout();
+    void benchmarkApplyState();
+    void benchmarkShadowGeometry();
+    void benchmarkButtonFootprint_data();
+    void benchmarkButtonFootprint();
+};
+
+void DecorationBenchmark::benchmarkCreate()
+{
+    MockBridge bridge;
+    QBENCHMARK {
+        MockDecoration deco(&bridge);
+    }
+}
+
+void DecorationBenchmark::benchmarkHoverMove()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(200);
+    client->setHeight(100);
+    deco.setBorders(QMargins(4, 24, 4, 4));
+    deco.setTitleBar(QRect(4, 0, 200, 24));
+
+    std::vector<std::unique_ptr<MockButton>> buttons;
+    for (int i = 0; i < 6; ++i) {
+        auto button = std::make_unique<MockButton>(KDecoration3::DecorationButtonType::Custom, &deco);
+        button->setGeometry(QRectF(i < 3 ? 4 + i * 24 : 204 - (6 - i) * 24, 2, 20, 20));
+        buttons.push_back(std::move(button));
+    }
+
+    // sweep the pointer across the title bar, entering and leaving all buttons
+    QList<QPointF> positions;
+    for (int x = 0; x < 208; x += 3) {
+        positions.append(QPointF(x + 0.5, 10.5));
+    }
+    QBENCHMARK {
+        for (const QPointF &pos : std::as_const(positions)) {
+            QHoverEvent event(QEvent::HoverMove, pos, pos, pos);
+            QCoreApplication::sendEvent(&deco, &event);
+        }
+    }
+}
+
+void DecorationBenchmark::benchmarkPressRelease()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(200);
+    client->setHeight(100);
+    deco.setBorders(QMargins(4, 24, 4, 4));
+
+    MockButton button(KDecoration3::DecorationButtonType::Custom, &deco);
+    button.setGeometry(QRectF(4, 2, 20, 20));
+
+    const QPointF pos(10, 10);
+    QHoverEvent enter(QEvent::HoverEnter, pos, pos, QPointF(-1, -1));
+    QCoreApplication::sendEvent(&deco, &enter);
+    QBENCHMARK {
+        QMouseEvent press(QEvent::MouseButtonPress, pos, pos, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+        QCoreApplication::sendEvent(&deco, &press);
+        QMouseEvent release(QEvent::MouseButtonRelease, pos, pos, Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+        QCoreApplication::sendEvent(&deco, &release);
+    }
+}
+
+void DecorationBenchmark::benchmarkButtonGroupLayout()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+
+    KDecoration3::DecorationButtonGroup group(&deco);
+    for (int i = 0; i < 6; ++i) {
+        auto button = new MockButton(KDecoration3::DecorationButtonType::Custom, &deco, &group);
+        button->setGeometry(QRectF(0, 0, 20, 20));
+        group.addButton(button);
+    }
+
+    // every change of the position lays out all buttons again
+    int i = 0;
+    QBENCHMARK {
+        group.setPos(QPointF(++i % 2, 0));
+    }
+}
+
+void DecorationBenchmark::benchmarkApplyState()
+{
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(200);
+    client->setHeight(100);
+
+    // MockDecoration applies the next state as soon as it changes
+    int i = 0;
+    QBENCHMARK {
+        ++i;
+        deco.setBorders(QMargins(4, 24 + i % 2, 4, 4));
+        deco.setBorderRadius(KDecoration3::BorderRadius(i % 2));
+    }
+}
+
+void DecorationBenchmark::benchmarkShadowGeometry()
+{
+    KDecoration3::DecorationShadow shadow;
+    shadow.setShadow(QImage(64, 64, QImage::Format_ARGB32_Premultiplied));
+    shadow.setInnerShadowRect(QRectF(20, 20, 24, 24));
+    shadow.setPadding(QMarginsF(16, 16, 16, 16));
+
+    QRectF sum;
+    QBENCHMARK {
+        sum |= shadow.topLeftGeometry();
+        sum |= shadow.topGeometry();
+        sum |= shadow.topRightGeometry();
+        sum |= shadow.rightGeometry();
+        sum |= shadow.bottomRightGeometry();
+        sum |= shadow.bottomGeometry();
+        sum |= shadow.bottomLeftGeometry();
+        sum |= shadow.leftGeometry();
+    }
+    QVERIFY(!sum.isEmpty());
+}
+
+void DecorationBenchmark::benchmarkButtonFootprint_data()
+{
+    QTest::addColumn<KDecoration3::DecorationButtonType>("type");
+
+    QTest::newRow("custom") << KDecoration3::DecorationButtonType::Custom;
+    QTest::newRow("menu") << KDecoration3::DecorationButtonType::Menu;
+    QTest::newRow("maximize") << KDecoration3::DecorationButtonType::Maximize;
+    QTest::newRow("spacer") << KDecoration3::DecorationButtonType::Spacer;
+}
+
+void DecorationBenchmark::benchmarkButtonFootprint()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+    QFETCH(KDecoration3::DecorationButtonType, type);
+
+    // the first button connects the decoration, that is not part of the per button cost
+    MockButton first(type, &deco);
+
+    constexpr int buttonCount = 100;
+    std::vector<std::unique_ptr<MockButton>> buttons;
+    buttons.reserve(buttonCount);
+    qint64 bytes = 0;
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < buttonCount; ++i) {
+            buttons.push_back(std::make_unique<MockButton>(type, &deco));
+        }
+        bytes = counter.bytes();
+    }
+    QTest::setBenchmarkResult(qreal(bytes) / buttonCount, QTest::BytesAllocated);
+}
+
+QTEST_MAIN(DecorationBenchmark)
+#include "decorationbenchmark.moc"
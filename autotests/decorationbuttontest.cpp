@@ -5,11 +5,13 @@
  */
 #include "../src/decoratedwindow.h"
 #include "../src/decorationsettings.h"
+#include "../src/decorationtracing.h"
 #include "mockbridge.h"
 #include "mockbutton.h"
 #include "mockdecoration.h"
 #include "mocksettings.h"
 #include "mockwindow.h"
+#include <KLocalizedString>
 #include <QSignalSpy>
 #include <QStyleHints>
 #include <QTest>
@@ -48,6 +50,9 @@ private Q_SLOTS:
     void testApplicationMenu();
     void testContains_data();
     void testContains();
+    void testStateChanged();
+    void testToolTip();
+    void testSharedStateDispatch();
 };
 
 void DecorationButtonTest::testButton()
@@ -1368,5 +1373,156 @@ void DecorationButtonTest::testContains()
     QTEST(button.contains(pos), "contains");
 }
 
+void DecorationButtonTest::testStateChanged()
+{
+    MockBridge bridge;
+    MockDecoration mockDecoration(&bridge);
+    MockButton button(KDecoration3::DecorationButtonType::Custom, &mockDecoration);
+    button.setGeometry(QRect(0, 0, 10, 10));
+
+    QSignalSpy stateChangedSpy(&button, &KDecoration3::DecorationButton::stateChanged);
+    QVERIFY(stateChangedSpy.isValid());
+    QSignalSpy damagedSpy(&mockDecoration, &KDecoration3::Decoration::damaged);
+    QVERIFY(damagedSpy.isValid());
+    QSignalSpy pressedSpy(&button, &KDecoration3::DecorationButton::pressed);
+    QSignalSpy releasedSpy(&button, &KDecoration3::DecorationButton::released);
+
+    // setting the same state does not notify
+    button.setEnabled(true);
+    QCOMPARE(stateChangedSpy.count(), 0);
+    QCOMPARE(damagedSpy.count(), 0);
+
+    QHoverEvent enter(QEvent::HoverEnter, QPointF(1, 1), QPointF(1, 1), QPointF(-1, -1));
+    button.event(&enter);
+    QCOMPARE(stateChangedSpy.count(), 1);
+    QCOMPARE(stateChangedSpy.last().first().value<KDecoration3::DecorationButton::States>(), KDecoration3::DecorationButton::State::Hovered);
+    QCOMPARE(damagedSpy.count(), 1);
+
+    QMouseEvent press(QEvent::MouseButtonPress, QPointF(1, 1), QPointF(1, 1), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    button.event(&press);
+    QCOMPARE(stateChangedSpy.count(), 2);
+    QCOMPARE(stateChangedSpy.last().first().value<KDecoration3::DecorationButton::States>(), KDecoration3::DecorationButton::State::Pressed);
+    QCOMPARE(damagedSpy.count(), 2);
+    QCOMPARE(pressedSpy.count(), 1);
+
+    // disabling a hovered and pressed button is one transition
+    button.setEnabled(false);
+    QCOMPARE(stateChangedSpy.count(), 3);
+    QCOMPARE(stateChangedSpy.last().first().value<KDecoration3::DecorationButton::States>(),
+             KDecoration3::DecorationButton::State::Enabled | KDecoration3::DecorationButton::State::Hovered | KDecoration3::DecorationButton::State::Pressed);
+    QCOMPARE(damagedSpy.count(), 3);
+    QCOMPARE(damagedSpy.last().first().value<QRegion>(), QRegion(0, 0, 10, 10));
+    QCOMPARE(releasedSpy.count(), 1);
+    QCOMPARE(button.isHovered(), false);
+    QCOMPARE(button.isPressed(), false);
+
+    // the same for hiding a hovered button
+    button.setEnabled(true);
+    button.event(&enter);
+    QCOMPARE(stateChangedSpy.count(), 5);
+    button.setVisible(false);
+    QCOMPARE(stateChangedSpy.count(), 6);
+    QCOMPARE(stateChangedSpy.last().first().value<KDecoration3::DecorationButton::States>(),
+             KDecoration3::DecorationButton::State::Visible | KDecoration3::DecorationButton::State::Hovered);
+    QCOMPARE(damagedSpy.count(), 6);
+}
+
+static int s_toolTipLookups = 0;
+
+void DecorationButtonTest::testToolTip()
+{
+    MockBridge bridge;
+    MockDecoration mockDecoration(&bridge);
+    MockWindow *client = bridge.lastCreatedWindow();
+    MockButton button(KDecoration3::DecorationButtonType::KeepAbove, &mockDecoration);
+    button.setGeometry(QRect(0, 0, 10, 10));
+
+    QHoverEvent enter(QEvent::HoverEnter, QPointF(1, 1), QPointF(1, 1), QPointF(-1, -1));
+    QHoverEvent leave(QEvent::HoverLeave, QPointF(20, 20), QPointF(20, 20), QPointF(1, 1));
+    button.event(&enter);
+    QCOMPARE(client->toolTip(), QStringLiteral("Keep above other windows"));
+    button.event(&leave);
+    QCOMPARE(client->toolTip(), QString());
+
+    // the cached tooltip depends on the checked state
+    button.setChecked(true);
+    button.event(&enter);
+    QCOMPARE(client->toolTip(), QStringLiteral("Don't keep above other windows"));
+    button.event(&leave);
+
+    // the lookups are traced, cached tooltips are not looked up again
+    KDecoration3::DecorationTracing::setCallback([](KDecoration3::DecorationTracing::Span span, KDecoration3::DecorationTracing::Phase phase, const QObject *) {
+        if (span == KDecoration3::DecorationTracing::Span::ToolTipLookup && phase == KDecoration3::DecorationTracing::Phase::Begin) {
+            s_toolTipLookups++;
+        }
+    });
+    s_toolTipLookups = 0;
+    button.setChecked(false);
+    button.event(&enter);
+    button.event(&leave);
+    QCOMPARE(s_toolTipLookups, 0);
+
+    // a language change clears the cache, without a catalogue the untranslated text is used
+    KLocalizedString::setLanguages({QStringLiteral("x-test-missing")});
+    button.event(&enter);
+    QCOMPARE(client->toolTip(), QStringLiteral("Keep above other windows"));
+    button.event(&leave);
+    QCOMPARE(s_toolTipLookups, 1);
+    button.event(&enter);
+    button.event(&leave);
+    QCOMPARE(s_toolTipLookups, 1);
+
+    KLocalizedString::clearLanguages();
+    button.event(&enter);
+    QCOMPARE(client->toolTip(), QStringLiteral("Keep above other windows"));
+    button.event(&leave);
+    QCOMPARE(s_toolTipLookups, 2);
+    KDecoration3::DecorationTracing::setCallback(nullptr);
+}
+
+void DecorationButtonTest::testSharedStateDispatch()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration mockDecoration(&bridge);
+    mockDecoration.setSettings(decoSettings);
+    MockWindow *client = bridge.lastCreatedWindow();
+    MockSettings *settings = bridge.lastCreatedSettings();
+    QVERIFY(settings);
+
+    // all buttons of the affected type follow the window
+    MockButton maximize(KDecoration3::DecorationButtonType::Maximize, &mockDecoration);
+    auto otherMaximize = std::make_unique<MockButton>(KDecoration3::DecorationButtonType::Maximize, &mockDecoration);
+    MockButton close(KDecoration3::DecorationButtonType::Close, &mockDecoration);
+    MockButton onAllDesktops(KDecoration3::DecorationButtonType::OnAllDesktops, &mockDecoration);
+    QCOMPARE(maximize.isEnabled(), false);
+    QCOMPARE(otherMaximize->isEnabled(), false);
+    QCOMPARE(close.isEnabled(), false);
+
+    client->setMaximizable(true);
+    QCOMPARE(maximize.isEnabled(), true);
+    QCOMPARE(otherMaximize->isEnabled(), true);
+    QCOMPARE(close.isEnabled(), false);
+
+    // a destroyed button is not updated anymore
+    otherMaximize.reset();
+    client->setMaximizable(false);
+    QCOMPARE(maximize.isEnabled(), false);
+    client->setCloseable(true);
+    QCOMPARE(close.isEnabled(), true);
+
+    settings->setOnAllDesktopsAvailabe(true);
+    QCOMPARE(onAllDesktops.isVisible(), true);
+
+    // buttons follow settings set after their creation
+    auto otherSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    mockDecoration.setSettings(otherSettings);
+    settings->setOnAllDesktopsAvailabe(false);
+    QCOMPARE(onAllDesktops.isVisible(), true);
+    bridge.lastCreatedSettings()->setOnAllDesktopsAvailabe(true);
+    bridge.lastCreatedSettings()->setOnAllDesktopsAvailabe(false);
+    QCOMPARE(onAllDesktops.isVisible(), false);
+}
+
 QTEST_MAIN(DecorationButtonTest)
 #include "decorationbuttontest.moc"
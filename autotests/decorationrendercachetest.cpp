@@ -0,0 +1,285 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#include "../src/decorationrendercache.h"
+#include "mockbridge.h"
+#include "mockdecoration.h"
+#include "mockwindow.h"
+#include <QPainter>
+#include <QTest>
+
+class DecorationRenderCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testTiles();
+    void testDamage();
+    void testScale();
+    void testNineSlice();
+    void testPrerender();
+    void testSharedAtlas();
+    void testDecorationDestroyed();
+};
+
+static void render(KDecoration3::DecorationRenderCache &cache, const QRegion &region, qreal scale = 1)
+{
+    QImage image(region.boundingRect().size() * scale, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(scale);
+    QPainter painter(&image);
+    cache.render(&painter, region, scale);
+}
+
+void DecorationRenderCacheTest::testTiles()
+{
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(5, 20, 5, 5));
+
+    KDecoration3::DecorationRenderCache cache(&deco, 64);
+    QCOMPARE(cache.decoration(), &deco);
+    QCOMPARE(cache.tileSize(), 64);
+
+    // the first render paints all tiles
+    render(cache, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco.paintedRects.count(), 4);
+    QVERIFY(deco.paintedRects.contains(QRectF(0, 0, 64, 64)));
+    QVERIFY(deco.paintedRects.contains(QRectF(64, 64, 46, 61)));
+
+    // without damage nothing gets painted again
+    deco.paintedRects.clear();
+    render(cache, QRegion(0, 0, 110, 125));
+    QVERIFY(deco.paintedRects.isEmpty());
+
+    // only the tiles within the rendered region are painted
+    cache.invalidate();
+    render(cache, QRegion(0, 0, 10, 10));
+    QCOMPARE(deco.paintedRects, QList<QRectF>({QRectF(0, 0, 64, 64)}));
+}
+
+void DecorationRenderCacheTest::testDamage()
+{
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(5, 20, 5, 5));
+
+    KDecoration3::DecorationRenderCache cache(&deco, 64);
+    render(cache, QRegion(0, 0, 110, 125));
+
+    // damage repaints only the intersecting tiles
+    deco.paintedRects.clear();
+    deco.update(QRectF(70, 0, 10, 10));
+    render(cache, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco.paintedRects, QList<QRectF>({QRectF(64, 0, 46, 64)}));
+
+    deco.paintedRects.clear();
+    deco.update(QRectF(60, 60, 10, 10));
+    render(cache, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco.paintedRects.count(), 4);
+
+    // a new state repaints all tiles
+    deco.paintedRects.clear();
+    deco.setBorderRadius(KDecoration3::BorderRadius(1));
+    render(cache, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco.paintedRects.count(), 4);
+
+    // a new size discards the tiles
+    deco.paintedRects.clear();
+    client->setWidth(200);
+    render(cache, QRegion(0, 0, 210, 125));
+    QCOMPARE(deco.paintedRects.count(), 8);
+}
+
+void DecorationRenderCacheTest::testScale()
+{
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(5, 20, 5, 5));
+
+    KDecoration3::DecorationRenderCache cache(&deco, 64);
+    render(cache, QRegion(0, 0, 110, 125), 2);
+    QCOMPARE(deco.paintedRects.count(), 16);
+    QVERIFY(deco.paintedRects.contains(QRectF(0, 0, 32, 32)));
+
+    deco.paintedRects.clear();
+    render(cache, QRegion(0, 0, 110, 125), 2);
+    QVERIFY(deco.paintedRects.isEmpty());
+
+    render(cache, QRegion(0, 0, 110, 125), 1);
+    QCOMPARE(deco.paintedRects.count(), 4);
+}
+
+void DecorationRenderCacheTest::testNineSlice()
+{
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(5, 20, 5, 5));
+    deco.setTitleBar(QRect(5, 0, 100, 20));
+
+    KDecoration3::DecorationRenderCache cache(&deco);
+    cache.setMode(KDecoration3::DecorationRenderCache::Mode::NineSlice);
+    QCOMPARE(cache.mode(), KDecoration3::DecorationRenderCache::Mode::NineSlice);
+
+    // the corners and edges are painted once, the title bar separately
+    render(cache, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco.paintedRects.count(), 9);
+    QVERIFY(deco.paintedRects.contains(QRectF(0, 0, 5, 20)));
+    QVERIFY(deco.paintedRects.contains(QRectF(5, 0, 1, 20)));
+    QVERIFY(deco.paintedRects.contains(QRectF(105, 120, 5, 5)));
+    QVERIFY(deco.paintedRects.contains(QRectF(5, 0, 100, 20)));
+
+    deco.paintedRects.clear();
+    render(cache, QRegion(0, 0, 110, 125));
+    QVERIFY(deco.paintedRects.isEmpty());
+
+    // resizing only repaints the title bar
+    client->setWidth(200);
+    deco.setTitleBar(QRect(5, 0, 200, 20));
+    render(cache, QRegion(0, 0, 210, 125));
+    QCOMPARE(deco.paintedRects, QList<QRectF>({QRectF(5, 0, 200, 20)}));
+
+    // unless the borders got damaged during the resize
+    deco.paintedRects.clear();
+    client->setWidth(150);
+    deco.setTitleBar(QRect(5, 0, 150, 20));
+    deco.update(QRectF(0, 50, 2, 2));
+    render(cache, QRegion(0, 0, 160, 125));
+    QCOMPARE(deco.paintedRects.count(), 9);
+
+    deco.paintedRects.clear();
+    client->setWidth(200);
+    deco.setTitleBar(QRect(5, 0, 200, 20));
+    render(cache, QRegion(0, 0, 210, 125));
+    QCOMPARE(deco.paintedRects, QList<QRectF>({QRectF(5, 0, 200, 20)}));
+
+    // damage within the title bar only repaints the title bar
+    deco.paintedRects.clear();
+    deco.update(QRectF(50, 5, 10, 10));
+    render(cache, QRegion(0, 0, 210, 125));
+    QCOMPARE(deco.paintedRects, QList<QRectF>({QRectF(5, 0, 200, 20)}));
+
+    // damage outside of the title bar repaints the corners and edges
+    deco.paintedRects.clear();
+    deco.update(QRectF(0, 50, 2, 2));
+    render(cache, QRegion(0, 0, 210, 125));
+    QCOMPARE(deco.paintedRects.count(), 8);
+
+    // a new state repaints everything
+    deco.paintedRects.clear();
+    deco.setBorderRadius(KDecoration3::BorderRadius(3));
+    render(cache, QRegion(0, 0, 210, 125));
+    QCOMPARE(deco.paintedRects.count(), 9);
+}
+
+void DecorationRenderCacheTest::testPrerender()
+{
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(5, 20, 5, 5));
+
+    KDecoration3::DecorationRenderCache cache(&deco, 64);
+    render(cache, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco.paintedRects.count(), 4);
+
+    // the content for the next scale is painted from the event loop
+    deco.paintedRects.clear();
+    client->setNextScale(2);
+    QVERIFY(!cache.isPrerendered(2));
+    QVERIFY(deco.paintedRects.isEmpty());
+    // one tile per event loop iteration
+    QCoreApplication::sendPostedEvents();
+    QCOMPARE(deco.paintedRects.count(), 1);
+    QVERIFY(!cache.isPrerendered(2));
+    QTRY_VERIFY(cache.isPrerendered(2));
+    QCOMPARE(deco.paintedRects.count(), 16);
+
+    // damage reaches the prerendered content as well
+    deco.paintedRects.clear();
+    deco.update(QRectF(0, 0, 10, 10));
+
+    // switching the scale only repaints the damaged tiles
+    render(cache, QRegion(0, 0, 110, 125), 2);
+    QCOMPARE(deco.paintedRects, QList<QRectF>({QRectF(0, 0, 32, 32)}));
+    QVERIFY(!cache.isPrerendered(2));
+}
+
+void DecorationRenderCacheTest::testSharedAtlas()
+{
+    auto setup = [](MockBridge &bridge, MockDecoration &deco) {
+        MockWindow *client = bridge.lastCreatedWindow();
+        client->setWidth(100);
+        client->setHeight(100);
+        deco.setBorders(QMargins(5, 20, 5, 5));
+        deco.setTitleBar(QRect(5, 0, 100, 20));
+    };
+    MockBridge bridge1;
+    MockDecoration deco1(&bridge1);
+    setup(bridge1, deco1);
+    MockBridge bridge2;
+    MockDecoration deco2(&bridge2);
+    setup(bridge2, deco2);
+    MockBridge bridge3;
+    MockDecoration deco3(&bridge3);
+    setup(bridge3, deco3);
+
+    KDecoration3::DecorationRenderCache cache1(&deco1);
+    cache1.setMode(KDecoration3::DecorationRenderCache::Mode::NineSlice);
+    cache1.setSharingKey(QStringLiteral("test"));
+    KDecoration3::DecorationRenderCache cache2(&deco2);
+    cache2.setMode(KDecoration3::DecorationRenderCache::Mode::NineSlice);
+    cache2.setSharingKey(QStringLiteral("test"));
+    QCOMPARE(cache2.sharingKey(), QStringLiteral("test"));
+    KDecoration3::DecorationRenderCache cache3(&deco3);
+    cache3.setMode(KDecoration3::DecorationRenderCache::Mode::NineSlice);
+
+    render(cache1, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco1.paintedRects.count(), 9);
+
+    // the second decoration reuses the corners and edges, only its title bar is painted
+    render(cache2, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco2.paintedRects, QList<QRectF>({QRectF(5, 0, 100, 20)}));
+
+    // without sharing key everything is painted
+    render(cache3, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco3.paintedRects.count(), 9);
+
+    // a different state doesn't match the shared atlas
+    deco1.paintedRects.clear();
+    deco2.paintedRects.clear();
+    deco2.setBorderRadius(KDecoration3::BorderRadius(3));
+    render(cache2, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco2.paintedRects.count(), 9);
+
+    deco1.setBorderRadius(KDecoration3::BorderRadius(3));
+    render(cache1, QRegion(0, 0, 110, 125));
+    QCOMPARE(deco1.paintedRects, QList<QRectF>({QRectF(5, 0, 100, 20)}));
+}
+
+void DecorationRenderCacheTest::testDecorationDestroyed()
+{
+    MockBridge bridge;
+    auto deco = std::make_unique<MockDecoration>(&bridge);
+    KDecoration3::DecorationRenderCache cache(deco.get());
+    deco.reset();
+    QCOMPARE(cache.decoration(), nullptr);
+    render(cache, QRegion(0, 0, 10, 10));
+}
+
+QTEST_MAIN(DecorationRenderCacheTest)
+#include "decorationrendercachetest.moc"
@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#include "../src/decorationsettings.h"
+#include "../src/private/decorationeventrecorder.h"
+#include "mockbridge.h"
+#include "mockbutton.h"
+#include "mockdecoration.h"
+#include "mockwindow.h"
+#include <QCommandLineParser>
+#include <QFile>
+#include <QGuiApplication>
+#include <QTextStream>
+
+// Replays a recording made with DecorationEventRecorder against a mock decoration
+// and reports how fast the events were processed.
+int main(int argc, char **argv)
+{
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Replays recorded decoration pointer events"));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("recording"), QStringLiteral("The recorded events"));
+    QCommandLineOption widthOption(QStringLiteral("width"), QStringLiteral("Width of the window"), QStringLiteral("width"), QStringLiteral("800"));
+    QCommandLineOption heightOption(QStringLiteral("height"), QStringLiteral("Height of the window"), QStringLiteral("height"), QStringLiteral("600"));
+    parser.addOption(widthOption);
+    parser.addOption(heightOption);
+    parser.process(app);
+
+    QTextStream out(stdout);
+    if (parser.positionalArguments().count() != 1) {
+        parser.showHelp(1);
+    }
+    QFile file(parser.positionalArguments().first());
+    if (!file.open(QIODevice::ReadOnly)) {
+        out << "Failed to open " << file.fileName() << Qt::endl;
+        return 1;
+    }
+    KDecoration3::DecorationEventPlayer player(&file);
+    if (!player.isValid()) {
+        out << file.fileName() << " is not a decoration event recording" << Qt::endl;
+        return 1;
+    }
+
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    deco.setSettings(std::make_shared<KDecoration3::DecorationSettings>(&bridge));
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(parser.value(widthOption).toInt());
+    client->setHeight(parser.value(heightOption).toInt());
+    deco.setBorders(QMargins(4, 24, 4, 4));
+    deco.setTitleBar(QRect(4, 0, int(client->width()), 24));
+
+    // three buttons on each side of the title bar
+    std::vector<std::unique_ptr<MockButton>> buttons;
+    for (int i = 0; i < 6; ++i) {
+        auto button = std::make_unique<MockButton>(KDecoration3::DecorationButtonType::Custom, &deco);
+        const qreal x = i < 3 ? 4 + i * 24 : 4 + client->width() - (6 - i) * 24;
+        button->setGeometry(QRectF(x, 2, 20, 20));
+        buttons.push_back(std::move(button));
+    }
+
+    int damaged = 0;
+    QObject::connect(&deco, &KDecoration3::Decoration::damaged, &deco, [&damaged]() {
+        damaged++;
+    });
+
+    const auto statistics = player.play(&deco);
+    const qreal seconds = statistics.elapsedNanoseconds / 1e9;
+    out << "events: " << statistics.events << Qt::endl;
+    out << "events/s: " << (seconds > 0 ? statistics.events / seconds : 0) << Qt::endl;
+    out << "time per event: " << (statistics.events > 0 ? statistics.elapsedNanoseconds / statistics.events : 0) << " ns" << Qt::endl;
+    out << "damage emissions: " << damaged << Qt::endl;
+    return 0;
+}
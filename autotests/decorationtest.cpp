@@ -3,15 +3,22 @@
  *
  * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
  */
+#include "../src/decorationbuttongroup.h"
 #include "../src/decorationsettings.h"
+#include "../src/decorationtracing.h"
 #include "mockbridge.h"
+#include "mockbutton.h"
 #include "mockdecoration.h"
 #include "mocksettings.h"
 #include "mockwindow.h"
+#include <QPainter>
 #include <QSignalSpy>
 #include <QTest>
 #include <QVariant>
 
+#include <atomic>
+#include <thread>
+
 class DecorationTest : public QObject
 {
     Q_OBJECT
@@ -20,6 +27,19 @@ private Q_SLOTS:
     void testOpaque();
     void testSection_data();
     void testSection();
+    void testSectionInvalidation();
+    void testButtonHitTest();
+    void testDamageAccumulation();
+    void testStateDamage();
+    void testStateTransaction();
+    void testStateGeneration();
+    void testSnapshot();
+    void testStatistics();
+    void testTracing();
+    void testHoverCoalescing();
+    void testLightweightButtons();
+    void testLightweightMenuDoubleClick();
+    void testFontCache();
 };
 
 #ifdef _MSC_VER
@@ -147,5 +167,707 @@ void DecorationTest::testSection()
     QCOMPARE(spy.last().first().value<Qt::WindowFrameSection>(), Qt::NoSection);
 }
 
+void DecorationTest::testSectionInvalidation()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+
+    MockSettings *settings = bridge.lastCreatedSettings();
+    settings->setLargeSpacing(0);
+
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(1, 10, 1, 1));
+    deco.setTitleBar(QRect(1, 1, 98, 8));
+
+    auto hover = [&deco](const QPoint &pos) {
+        QHoverEvent event(QEvent::HoverMove, QPointF(pos), QPointF(pos), QPointF(pos));
+        QCoreApplication::sendEvent(&deco, &event);
+    };
+
+    hover(QPoint(101, 50));
+    QCOMPARE(deco.sectionUnderMouse(), Qt::RightSection);
+    hover(QPoint(101, 60));
+    QCOMPARE(deco.sectionUnderMouse(), Qt::RightSection);
+
+    // growing the window moves the right border away from the pointer
+    client->setWidth(200);
+    hover(QPoint(101, 60));
+    QCOMPARE(deco.sectionUnderMouse(), Qt::NoSection);
+
+    // so does changing the borders
+    deco.setBorders(QMargins(1, 10, 10, 1));
+    hover(QPoint(205, 60));
+    QCOMPARE(deco.sectionUnderMouse(), Qt::RightSection);
+
+    // and the title bar
+    hover(QPoint(50, 0));
+    QCOMPARE(deco.sectionUnderMouse(), Qt::TopSection);
+    deco.setTitleBar(QRect(1, 0, 98, 8));
+    hover(QPoint(50, 0));
+    QCOMPARE(deco.sectionUnderMouse(), Qt::TitleBarArea);
+}
+
+void DecorationTest::testButtonHitTest()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+
+    MockButton left(KDecoration3::DecorationButtonType::Custom, &deco);
+    left.setGeometry(QRectF(20, 0, 10, 10));
+    MockButton right(KDecoration3::DecorationButtonType::Custom, &deco);
+    right.setGeometry(QRectF(0, 0, 10, 10));
+    MockButton hidden(KDecoration3::DecorationButtonType::Custom, &deco);
+    hidden.setGeometry(QRectF(40, 0, 10, 10));
+    hidden.setVisible(false);
+
+    auto hover = [&deco](const QPointF &pos) {
+        QHoverEvent event(QEvent::HoverMove, pos, pos, pos);
+        QCoreApplication::sendEvent(&deco, &event);
+    };
+
+    hover(QPointF(5, 5));
+    QCOMPARE(right.isHovered(), true);
+    QCOMPARE(left.isHovered(), false);
+
+    hover(QPointF(25.5, 9.9));
+    QCOMPARE(right.isHovered(), false);
+    QCOMPARE(left.isHovered(), true);
+
+    // hidden buttons are never hit
+    hover(QPointF(45, 5));
+    QCOMPARE(left.isHovered(), false);
+    QCOMPARE(hidden.isHovered(), false);
+
+    // geometry changes are picked up
+    hidden.setVisible(true);
+    left.setGeometry(QRectF(40, 0, 10, 10));
+    hidden.setGeometry(QRectF(60, 0, 10, 10));
+    hover(QPointF(45, 5));
+    QCOMPARE(left.isHovered(), true);
+    QCOMPARE(hidden.isHovered(), false);
+
+    // press and release are routed to the hovered button
+    QSignalSpy clickedSpy(&left, &KDecoration3::DecorationButton::clicked);
+    QMouseEvent press(QEvent::MouseButtonPress, QPointF(45, 5), QPointF(45, 5), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &press);
+    QCOMPARE(left.isPressed(), true);
+    QMouseEvent release(QEvent::MouseButtonRelease, QPointF(45, 5), QPointF(45, 5), Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QCOMPARE(QCoreApplication::sendEvent(&deco, &release), true);
+    QCOMPARE(left.isPressed(), false);
+    QCOMPARE(clickedSpy.count(), 1);
+
+    // disabling a button removes it from the hit test
+    left.setEnabled(false);
+    hover(QPointF(46, 5));
+    QCOMPARE(left.isHovered(), false);
+
+    QHoverEvent leave(QEvent::HoverLeave, QPointF(-1, -1), QPointF(-1, -1), QPointF(46, 5));
+    QCoreApplication::sendEvent(&deco, &leave);
+    QCOMPARE(right.isHovered(), false);
+    QCOMPARE(deco.sectionUnderMouse(), Qt::NoSection);
+}
+
+void DecorationTest::testDamageAccumulation()
+{
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    QSignalSpy damagedSpy(&deco, &KDecoration3::Decoration::damaged);
+    QVERIFY(damagedSpy.isValid());
+
+    // by default every repaint request is forwarded
+    deco.update(QRectF(0, 0, 10, 10));
+    deco.update(QRectF(20, 0, 10, 10));
+    QCOMPARE(damagedSpy.count(), 2);
+    QCOMPARE(deco.takeDamage(), QRegion());
+
+    damagedSpy.clear();
+    deco.setDamageAccumulationEnabled(true);
+    QCOMPARE(deco.isDamageAccumulationEnabled(), true);
+    deco.update(QRectF(0, 0, 10, 10));
+    deco.update(QRectF(20, 0, 10, 10));
+    deco.update(QRectF(5, 5, 10, 10));
+    QCOMPARE(damagedSpy.count(), 1);
+    QCOMPARE(deco.takeDamage(), QRegion(0, 0, 10, 10) + QRegion(20, 0, 10, 10) + QRegion(5, 5, 10, 10));
+    QCOMPARE(deco.takeDamage(), QRegion());
+
+    // the next frame gets notified again
+    deco.update(QRectF(0, 0, 1, 1));
+    QCOMPARE(damagedSpy.count(), 2);
+    QCOMPARE(damagedSpy.last().first().value<QRegion>(), QRegion(0, 0, 1, 1));
+
+    // disabling flushes the pending damage
+    deco.update(QRectF(2, 2, 1, 1));
+    QCOMPARE(damagedSpy.count(), 2);
+    deco.setDamageAccumulationEnabled(false);
+    QCOMPARE(damagedSpy.count(), 3);
+    QCOMPARE(damagedSpy.last().first().value<QRegion>(), QRegion(0, 0, 1, 1) + QRegion(2, 2, 1, 1));
+}
+
+void DecorationTest::testStateDamage()
+{
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+
+    QSignalSpy damagedSpy(&deco, &KDecoration3::Decoration::damaged);
+    QVERIFY(damagedSpy.isValid());
+
+    // changing the borders repaints the frame, but not the window contents
+    deco.setBorders(QMargins(5, 20, 5, 5));
+    QCOMPARE(damagedSpy.count(), 1);
+    QCOMPARE(damagedSpy.last().first().value<QRegion>(), QRegion(0, 0, 110, 125) - QRegion(5, 20, 100, 100));
+
+    // changing a single corner radius only repaints that corner
+    deco.setBorderRadius(KDecoration3::BorderRadius(3, 0, 0, 0));
+    QCOMPARE(damagedSpy.count(), 2);
+    QCOMPARE(damagedSpy.last().first().value<QRegion>(), QRegion(0, 0, 8, 23));
+
+    deco.setBorderRadius(KDecoration3::BorderRadius(3, 0, 4, 0));
+    QCOMPARE(damagedSpy.count(), 3);
+    QCOMPARE(damagedSpy.last().first().value<QRegion>(), QRegion(101, 116, 9, 9));
+
+    // changing the outline repaints a band along the edges
+    deco.setBorderOutline(KDecoration3::BorderOutline(2, Qt::red));
+    QCOMPARE(damagedSpy.count(), 4);
+    QCOMPARE(damagedSpy.last().first().value<QRegion>(), QRegion(0, 0, 110, 125) - QRegion(2, 2, 106, 121));
+
+    // re-applying identical values doesn't repaint anything
+    auto state = deco.currentState()->clone();
+    state->setBorders(QMargins(1, 1, 1, 1));
+    state->setBorders(QMargins(5, 20, 5, 5));
+    state->setBorderRadius(KDecoration3::BorderRadius());
+    state->setBorderRadius(KDecoration3::BorderRadius(3, 0, 4, 0));
+    QVERIFY(state->changedFields(*deco.currentState()) != KDecoration3::DecorationState::Fields());
+    deco.apply(state);
+    QCOMPARE(deco.currentState(), state);
+    deco.apply(deco.currentState()->clone());
+    QCOMPARE(damagedSpy.count(), 4);
+}
+
+void DecorationTest::testStateTransaction()
+{
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    QSignalSpy nextStateChangedSpy(&deco, &KDecoration3::Decoration::nextStateChanged);
+    QVERIFY(nextStateChangedSpy.isValid());
+
+    {
+        KDecoration3::DecorationStateTransaction transaction(&deco);
+        deco.setBorders(QMargins(1, 2, 3, 4));
+        deco.setBorderRadius(KDecoration3::BorderRadius(5));
+        {
+            KDecoration3::DecorationStateTransaction nested(&deco);
+            deco.setBorderOutline(KDecoration3::BorderOutline(1));
+        }
+        QCOMPARE(nextStateChangedSpy.count(), 0);
+        QCOMPARE(deco.borders(), QMarginsF());
+    }
+    QCOMPARE(nextStateChangedSpy.count(), 1);
+    QCOMPARE(deco.borders(), QMarginsF(1, 2, 3, 4));
+    QCOMPARE(deco.borderRadius(), KDecoration3::BorderRadius(5));
+    QCOMPARE(deco.borderOutline(), KDecoration3::BorderOutline(1));
+
+    // a batch without changes doesn't notify
+    deco.beginStateChanges();
+    deco.setBorders(QMargins(1, 2, 3, 4));
+    deco.commitStateChanges();
+    QCOMPARE(nextStateChangedSpy.count(), 1);
+}
+
+class CustomState : public KDecoration3::DecorationState
+{
+public:
+    std::shared_ptr<KDecoration3::DecorationState> clone() const override
+    {
+        return std::make_shared<CustomState>(*this);
+    }
+
+    void setCustom(int value)
+    {
+        custom = value;
+        markDirty(Field::Custom);
+    }
+
+    int custom = 0;
+};
+
+void DecorationTest::testStateGeneration()
+{
+    using Field = KDecoration3::DecorationState::Field;
+
+    CustomState state;
+    QCOMPARE(state.generation(), quint64(0));
+
+    state.setBorders(QMarginsF(1, 2, 3, 4));
+    const quint64 generation = state.generation();
+    QVERIFY(generation > 0);
+
+    // setting the same value doesn't modify the state
+    state.setBorders(QMarginsF(1, 2, 3, 4));
+    QCOMPARE(state.generation(), generation);
+
+    // a copy shares the generation until it gets modified
+    const auto copy = state.clone();
+    QCOMPARE(copy->generation(), generation);
+    QCOMPARE(copy->changedFields(state), KDecoration3::DecorationState::Fields());
+
+    copy->setBorderRadius(KDecoration3::BorderRadius(2));
+    QVERIFY(copy->generation() > generation);
+    QCOMPARE(state.generation(), generation);
+    QCOMPARE(copy->changedFields(state), KDecoration3::DecorationState::Fields(Field::BorderRadius));
+    QCOMPARE(state.changedFields(*copy), KDecoration3::DecorationState::Fields(Field::BorderRadius));
+
+    copy->setBorderOutline(KDecoration3::BorderOutline(1));
+    QCOMPARE(copy->changedFields(state), Field::BorderRadius | Field::BorderOutline);
+
+    static_cast<CustomState *>(copy.get())->setCustom(42);
+    QCOMPARE(copy->changedFields(state), Field::BorderRadius | Field::BorderOutline | Field::Custom);
+}
+
+void DecorationTest::testSnapshot()
+{
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+
+    auto snapshot = deco.snapshot();
+    QVERIFY(snapshot);
+    QCOMPARE(snapshot->size(), QSizeF(100, 100));
+    QCOMPARE(snapshot->state()->borders(), QMarginsF());
+
+    // applying a new state publishes a new snapshot, old snapshots stay untouched
+    deco.setBorders(QMargins(1, 2, 3, 4));
+    QCOMPARE(snapshot->state()->borders(), QMarginsF());
+    QCOMPARE(snapshot->size(), QSizeF(100, 100));
+    auto next = deco.snapshot();
+    QVERIFY(next != snapshot);
+    QCOMPARE(next->state()->borders(), QMarginsF(1, 2, 3, 4));
+    QCOMPARE(next->size(), QSizeF(104, 106));
+
+    deco.setTitleBar(QRectF(0, 0, 104, 2));
+    QCOMPARE(deco.snapshot()->titleBar(), QRectF(0, 0, 104, 2));
+    QCOMPARE(next->titleBar(), QRectF());
+
+    // a reader thread always sees a consistent snapshot
+    std::atomic<bool> done = false;
+    std::atomic<bool> consistent = true;
+    std::thread reader([&deco, &done, &consistent] {
+        while (!done) {
+            const auto snapshot = deco.snapshot();
+            const QMarginsF borders = snapshot->state()->borders();
+            if (snapshot->size() != QSizeF(100 + borders.left() + borders.right(), 100 + borders.top() + borders.bottom())) {
+                consistent = false;
+            }
+        }
+    });
+    for (int i = 0; i < 1000; ++i) {
+        deco.setBorders(QMargins(i % 7, i % 5, i % 3, i % 2));
+    }
+    done = true;
+    reader.join();
+    QVERIFY(consistent);
+
+    // snapshots which are not referenced anymore get recycled during a resize
+    snapshot.reset();
+    next.reset();
+    client->setWidth(110);
+    const KDecoration3::DecorationSnapshot *recycled = deco.snapshot().get();
+    client->setWidth(120);
+    client->setWidth(130);
+    QCOMPARE(deco.snapshot().get(), recycled);
+    QCOMPARE(deco.snapshot()->size(), deco.size());
+}
+
+void DecorationTest::testStatistics()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+
+    // nothing is collected by default
+    QCOMPARE(deco.isStatisticsEnabled(), false);
+    deco.update(QRectF(0, 0, 10, 10));
+    QCOMPARE(deco.statistics().damagedEmissions(), quint64(0));
+
+    deco.setStatisticsEnabled(true);
+    QCOMPARE(deco.isStatisticsEnabled(), true);
+    deco.update(QRectF(0, 0, 10, 10));
+    deco.update(QRectF(0, 0, 10, 20));
+    QCOMPARE(deco.statistics().damagedEmissions(), quint64(2));
+    QCOMPARE(deco.statistics().damagedArea(), quint64(300));
+
+    deco.setBorders(QMargins(4, 24, 4, 4));
+    QCOMPARE(deco.statistics().stateApplies(), quint64(1));
+
+    deco.resetStatistics();
+    QCOMPARE(deco.statistics().damagedEmissions(), quint64(0));
+    QCOMPARE(deco.statistics().stateApplies(), quint64(0));
+
+    MockButton button(KDecoration3::DecorationButtonType::Custom, &deco);
+    button.setGeometry(QRectF(10, 2, 20, 20));
+    QHoverEvent move(QEvent::HoverMove, QPointF(15, 10), QPointF(15, 10), QPointF(0, 0));
+    QCoreApplication::sendEvent(&deco, &move);
+    QCOMPARE(deco.statistics().hoverEvents(), quint64(1));
+    QCOMPARE(deco.statistics().forwardedButtonEvents(), quint64(1));
+    QMouseEvent press(QEvent::MouseButtonPress, QPointF(15, 10), QPointF(15, 10), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &press);
+    QCOMPARE(deco.statistics().mouseEvents(), quint64(1));
+    QCOMPARE(deco.statistics().forwardedButtonEvents(), quint64(2));
+    QMouseEvent doubleClick(QEvent::MouseButtonDblClick, QPointF(50, 10), QPointF(50, 10), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &doubleClick);
+    QCOMPARE(deco.statistics().mouseEvents(), quint64(2));
+
+    KDecoration3::DecorationButtonGroup group(&deco);
+    group.addButton(new MockButton(KDecoration3::DecorationButtonType::Custom, &deco, &group));
+    QVERIFY(deco.statistics().layoutPasses() > 0);
+
+    deco.setStatisticsEnabled(false);
+    QCOMPARE(deco.statistics().layoutPasses(), quint64(0));
+}
+
+using TraceEvent = std::pair<KDecoration3::DecorationTracing::Span, KDecoration3::DecorationTracing::Phase>;
+static QList<TraceEvent> s_traceEvents;
+
+void DecorationTest::testTracing()
+{
+    using Span = KDecoration3::DecorationTracing::Span;
+    using Phase = KDecoration3::DecorationTracing::Phase;
+
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+
+    KDecoration3::DecorationTracing::setCallback([](Span span, Phase phase, const QObject *object) {
+        Q_UNUSED(object)
+        s_traceEvents.append(TraceEvent(span, phase));
+    });
+    QVERIFY(KDecoration3::DecorationTracing::callback());
+
+    deco.setBorders(QMargins(1, 2, 3, 4));
+    QCOMPARE(s_traceEvents, QList<TraceEvent>({{Span::ApplyState, Phase::Begin}, {Span::ApplyState, Phase::End}}));
+
+    s_traceEvents.clear();
+    MockButton button(KDecoration3::DecorationButtonType::Custom, &deco);
+    QCOMPARE(s_traceEvents, QList<TraceEvent>({{Span::ButtonCreation, Phase::Begin}, {Span::ButtonCreation, Phase::End}}));
+
+    s_traceEvents.clear();
+    QHoverEvent move(QEvent::HoverMove, QPointF(5, 5), QPointF(5, 5), QPointF(0, 0));
+    QCoreApplication::sendEvent(&deco, &move);
+    QCOMPARE(s_traceEvents, QList<TraceEvent>({{Span::HoverDispatch, Phase::Begin}, {Span::HoverDispatch, Phase::End}}));
+
+    // without callback nothing is traced
+    KDecoration3::DecorationTracing::setCallback(nullptr);
+    s_traceEvents.clear();
+    deco.setBorders(QMargins(4, 3, 2, 1));
+    QVERIFY(s_traceEvents.isEmpty());
+}
+
+void DecorationTest::testHoverCoalescing()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(4, 24, 4, 4));
+
+    MockButton button(KDecoration3::DecorationButtonType::Custom, &deco);
+    button.setGeometry(QRectF(10, 2, 20, 20));
+    QCOMPARE(deco.isHoverCoalescingEnabled(), false);
+    deco.setHoverCoalescingEnabled(true);
+    QCOMPARE(deco.isHoverCoalescingEnabled(), true);
+    QCOMPARE(deco.hoverFlushInterval(), std::chrono::milliseconds(16));
+    // only the explicit flushes process the pending position, until the interval is lowered again
+    deco.setHoverFlushInterval(std::chrono::hours(1));
+    deco.setStatisticsEnabled(true);
+
+    // only the last position of a burst of moves gets processed
+    for (int x = 40; x > 14; x -= 5) {
+        QHoverEvent move(QEvent::HoverMove, QPointF(x, 10), QPointF(x, 10), QPointF(x + 5, 10));
+        QCoreApplication::sendEvent(&deco, &move);
+        QVERIFY(move.isAccepted());
+    }
+    QCOMPARE(deco.statistics().hoverEvents(), quint64(6));
+    QCOMPARE(button.isHovered(), false);
+    QCoreApplication::processEvents();
+    QCOMPARE(button.isHovered(), false);
+    deco.flushHoverEvents();
+    QCOMPARE(button.isHovered(), true);
+    const quint64 forwarded = deco.statistics().forwardedButtonEvents();
+    QVERIFY(forwarded > 0);
+    QVERIFY(forwarded < 6);
+
+    // without a frame the position gets processed once the interval has passed
+    QHoverEvent leaveForTimer(QEvent::HoverMove, QPointF(50, 10), QPointF(50, 10), QPointF(15, 10));
+    QCoreApplication::sendEvent(&deco, &leaveForTimer);
+    QCOMPARE(button.isHovered(), true);
+    deco.setHoverFlushInterval(std::chrono::milliseconds(0));
+    QTRY_COMPARE(button.isHovered(), false);
+    deco.setHoverFlushInterval(std::chrono::hours(1));
+    QHoverEvent enterForTimer(QEvent::HoverMove, QPointF(15, 10), QPointF(15, 10), QPointF(50, 10));
+    QCoreApplication::sendEvent(&deco, &enterForTimer);
+    deco.flushHoverEvents();
+    QCOMPARE(button.isHovered(), true);
+
+    // taking the damage processes the pending position
+    QHoverEvent leaveButton(QEvent::HoverMove, QPointF(50, 10), QPointF(50, 10), QPointF(15, 10));
+    QCoreApplication::sendEvent(&deco, &leaveButton);
+    QCOMPARE(button.isHovered(), true);
+    deco.takeDamage();
+    QCOMPARE(button.isHovered(), false);
+
+    // a press is delivered to the button under the latest position
+    QHoverEvent enterButton(QEvent::HoverMove, QPointF(15, 10), QPointF(15, 10), QPointF(50, 10));
+    QCoreApplication::sendEvent(&deco, &enterButton);
+    QCOMPARE(button.isHovered(), false);
+    QSignalSpy pressedSpy(&button, &KDecoration3::DecorationButton::pressed);
+    QMouseEvent press(QEvent::MouseButtonPress, QPointF(15, 10), QPointF(15, 10), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &press);
+    QCOMPARE(button.isHovered(), true);
+    QCOMPARE(pressedSpy.count(), 1);
+
+    // so is a double click
+    QMouseEvent release(QEvent::MouseButtonRelease, QPointF(15, 10), QPointF(15, 10), Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &release);
+    QHoverEvent leaveForDoubleClick(QEvent::HoverMove, QPointF(50, 10), QPointF(50, 10), QPointF(15, 10));
+    QCoreApplication::sendEvent(&deco, &leaveForDoubleClick);
+    QCOMPARE(button.isHovered(), true);
+    QMouseEvent doubleClick(QEvent::MouseButtonDblClick, QPointF(50, 10), QPointF(50, 10), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &doubleClick);
+    QCOMPARE(button.isHovered(), false);
+
+    // disabling coalescing processes the pending position
+    QHoverEvent enterAgain(QEvent::HoverMove, QPointF(15, 10), QPointF(15, 10), QPointF(50, 10));
+    QCoreApplication::sendEvent(&deco, &enterAgain);
+    QCOMPARE(button.isHovered(), false);
+    deco.setHoverCoalescingEnabled(false);
+    QCOMPARE(button.isHovered(), true);
+}
+
+void DecorationTest::testLightweightButtons()
+{
+    using State = KDecoration3::DecorationButton::State;
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(4, 24, 4, 4));
+
+    KDecoration3::DecorationButtonGroup group(&deco);
+    group.setSpacing(2);
+    group.addLightweightButton(KDecoration3::DecorationButtonType::ContextHelp, QSizeF(20, 20));
+    group.addLightweightButton(KDecoration3::DecorationButtonType::Close, QSizeF(20, 20));
+    QVERIFY(group.buttons().isEmpty());
+    QVERIFY(group.hasButton(KDecoration3::DecorationButtonType::Close));
+    QCOMPARE(group.lightweightButtons().count(), 2);
+
+    // the context help button is hidden, the close button disabled
+    auto close = group.lightweightButtons().last();
+    QCOMPARE(group.lightweightButtons().first().state.testFlag(State::Visible), false);
+    QCOMPARE(close.state.testFlag(State::Enabled), false);
+    QCOMPARE(close.geometry, QRectF(0, 0, 20, 20));
+    QCOMPARE(group.geometry(), QRectF(0, 0, 20, 20));
+
+    {
+        // hidden buttons don't add any spacing
+        KDecoration3::DecorationButtonGroup mixedGroup(&deco);
+        mixedGroup.setSpacing(2);
+        auto button = new MockButton(KDecoration3::DecorationButtonType::Custom, &deco, &mixedGroup);
+        button->setGeometry(QRectF(0, 0, 20, 20));
+        mixedGroup.addButton(button);
+        mixedGroup.addLightweightButton(KDecoration3::DecorationButtonType::ContextHelp, QSizeF(20, 20));
+        QCOMPARE(mixedGroup.geometry(), QRectF(0, 0, 20, 20));
+        mixedGroup.addLightweightButton(KDecoration3::DecorationButtonType::KeepAbove, QSizeF(20, 20));
+        QCOMPARE(mixedGroup.geometry(), QRectF(0, 0, 42, 20));
+
+        // a hidden DecorationButton at the end still adds its spacing, as it always did
+        KDecoration3::DecorationButtonGroup buttonGroup(&deco);
+        buttonGroup.setSpacing(2);
+        auto visibleButton = new MockButton(KDecoration3::DecorationButtonType::Custom, &deco, &buttonGroup);
+        visibleButton->setGeometry(QRectF(0, 0, 20, 20));
+        buttonGroup.addButton(visibleButton);
+        auto hiddenButton = new MockButton(KDecoration3::DecorationButtonType::Custom, &deco, &buttonGroup);
+        hiddenButton->setGeometry(QRectF(0, 0, 20, 20));
+        hiddenButton->setVisible(false);
+        buttonGroup.addButton(hiddenButton);
+        QCOMPARE(buttonGroup.geometry(), QRectF(0, 0, 22, 20));
+        // and is not doubled before a lightweight button
+        buttonGroup.addLightweightButton(KDecoration3::DecorationButtonType::KeepAbove, QSizeF(20, 20));
+        QCOMPARE(buttonGroup.geometry(), QRectF(0, 0, 42, 20));
+    }
+
+    // the buttons follow the window
+    client->setProvidesContextHelp(true);
+    client->setCloseable(true);
+    close = group.lightweightButtons().last();
+    QCOMPARE(close.state.testFlag(State::Enabled), true);
+    QCOMPARE(close.geometry, QRectF(22, 0, 20, 20));
+    QCOMPARE(group.geometry(), QRectF(0, 0, 42, 20));
+
+    group.setPos(QPointF(10, 2));
+    close = group.lightweightButtons().last();
+    QCOMPARE(close.geometry, QRectF(32, 2, 20, 20));
+
+    // hovering, pressing and releasing
+    QHoverEvent move(QEvent::HoverMove, QPointF(40, 10), QPointF(40, 10), QPointF(0, 0));
+    QCoreApplication::sendEvent(&deco, &move);
+    QCOMPARE(group.lightweightButtons().last().state.testFlag(State::Hovered), true);
+    QCOMPARE(group.lightweightButtons().first().state.testFlag(State::Hovered), false);
+
+    QSignalSpy closeRequestedSpy(client, &MockWindow::closeRequested);
+    QMouseEvent press(QEvent::MouseButtonPress, QPointF(40, 10), QPointF(40, 10), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    press.setAccepted(false);
+    QCoreApplication::sendEvent(&deco, &press);
+    QVERIFY(press.isAccepted());
+    QCOMPARE(group.lightweightButtons().last().state.testFlag(State::Pressed), true);
+    QMouseEvent release(QEvent::MouseButtonRelease, QPointF(40, 10), QPointF(40, 10), Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &release);
+    QCOMPARE(group.lightweightButtons().last().state.testFlag(State::Pressed), false);
+    QVERIFY(closeRequestedSpy.wait());
+
+    // releasing outside of the button does not click
+    QCoreApplication::sendEvent(&deco, &press);
+    QMouseEvent moveOut(QEvent::MouseMove, QPointF(80, 10), QPointF(80, 10), Qt::NoButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &moveOut);
+    QCOMPARE(group.lightweightButtons().last().state.testFlag(State::Hovered), false);
+    QMouseEvent releaseOut(QEvent::MouseButtonRelease, QPointF(80, 10), QPointF(80, 10), Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &releaseOut);
+    QCoreApplication::processEvents();
+    QCOMPARE(closeRequestedSpy.count(), 1);
+
+    // disabling clears the hover state
+    QCoreApplication::sendEvent(&deco, &move);
+    QCOMPARE(group.lightweightButtons().last().state.testFlag(State::Hovered), true);
+    client->setCloseable(false);
+    QCOMPARE(group.lightweightButtons().last().state, KDecoration3::DecorationButton::States(State::Visible));
+
+    // the visible lightweight buttons get painted by the painter
+    QList<KDecoration3::DecorationButtonType> painted;
+    group.setLightweightButtonPainter([&painted](QPainter *, const KDecoration3::DecorationButtonGroup::LightweightButton &button, const QRectF &) {
+        painted.append(button.type);
+    });
+    QImage image(100, 40, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    group.paint(&painter, QRectF(0, 0, 100, 40));
+    QCOMPARE(painted, QList<KDecoration3::DecorationButtonType>({KDecoration3::DecorationButtonType::ContextHelp, KDecoration3::DecorationButtonType::Close}));
+
+    group.removeButton(KDecoration3::DecorationButtonType::Close);
+    QCOMPARE(group.lightweightButtons().count(), 1);
+    QCOMPARE(group.hasButton(KDecoration3::DecorationButtonType::Close), false);
+}
+
+void DecorationTest::testLightweightMenuDoubleClick()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(4, 24, 4, 4));
+    MockSettings *settings = bridge.lastCreatedSettings();
+    QVERIFY(settings);
+    settings->setCloseOnDoubleClickOnMenu(true);
+
+    KDecoration3::DecorationButtonGroup group(&deco);
+    group.addLightweightButton(KDecoration3::DecorationButtonType::Menu, QSizeF(20, 20));
+    group.setPos(QPointF(10, 2));
+
+    QSignalSpy closeRequestedSpy(client, &MockWindow::closeRequested);
+    QVERIFY(closeRequestedSpy.isValid());
+    QSignalSpy menuRequestedSpy(client, &MockWindow::menuRequested);
+    QVERIFY(menuRequestedSpy.isValid());
+
+    QHoverEvent move(QEvent::HoverMove, QPointF(15, 10), QPointF(15, 10), QPointF(0, 0));
+    QCoreApplication::sendEvent(&deco, &move);
+    QMouseEvent press(QEvent::MouseButtonPress, QPointF(15, 10), QPointF(15, 10), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QMouseEvent release(QEvent::MouseButtonRelease, QPointF(15, 10), QPointF(15, 10), Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+
+    // the first click must not open the window menu, it would grab the pointer
+    QCoreApplication::sendEvent(&deco, &press);
+    QCoreApplication::sendEvent(&deco, &release);
+    QCoreApplication::processEvents();
+    QCOMPARE(menuRequestedSpy.count(), 0);
+    QCOMPARE(closeRequestedSpy.count(), 0);
+
+    // the second click closes the window
+    QCoreApplication::sendEvent(&deco, &press);
+    QVERIFY(closeRequestedSpy.wait());
+    QCoreApplication::sendEvent(&deco, &release);
+    QCoreApplication::processEvents();
+    QCOMPARE(closeRequestedSpy.count(), 1);
+    QCOMPARE(menuRequestedSpy.count(), 0);
+
+    // a right click still opens the window menu
+    QMouseEvent rightPress(QEvent::MouseButtonPress, QPointF(15, 10), QPointF(15, 10), Qt::RightButton, Qt::RightButton, Qt::NoModifier);
+    QMouseEvent rightRelease(QEvent::MouseButtonRelease, QPointF(15, 10), QPointF(15, 10), Qt::RightButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &rightPress);
+    QCoreApplication::sendEvent(&deco, &rightRelease);
+    QVERIFY(menuRequestedSpy.wait());
+    QCOMPARE(closeRequestedSpy.count(), 1);
+
+    // without closing on double click a left click opens the window menu
+    settings->setCloseOnDoubleClickOnMenu(false);
+    QCoreApplication::sendEvent(&deco, &press);
+    QCoreApplication::sendEvent(&deco, &release);
+    QVERIFY(menuRequestedSpy.wait());
+    QCOMPARE(menuRequestedSpy.count(), 2);
+    QCOMPARE(closeRequestedSpy.count(), 1);
+}
+
+void DecorationTest::testFontCache()
+{
+    MockBridge bridge;
+    KDecoration3::DecorationSettings settings(&bridge);
+    MockSettings *mockSettings = bridge.lastCreatedSettings();
+    QVERIFY(mockSettings);
+
+    // warm up the caches, afterwards the backend must not be queried any more
+    const QFont font = settings.font();
+    const QFontMetricsF metrics = settings.fontMetrics();
+    settings.fontMetrics(2);
+    const int queries = mockSettings->fontQueries();
+    for (int i = 0; i < 10; ++i) {
+        QCOMPARE(settings.font(), font);
+        QCOMPARE(settings.fontMetrics().height(), metrics.height());
+        settings.fontMetrics(2);
+    }
+    QCOMPARE(mockSettings->fontQueries(), queries);
+
+    // changing the font invalidates the caches
+    QFont newFont = font;
+    newFont.setPixelSize(10);
+    mockSettings->setFont(newFont);
+    QCOMPARE(settings.font().pixelSize(), 10);
+    QCOMPARE(settings.fontMetrics().height(), QFontMetricsF(newFont).height());
+    QVERIFY(mockSettings->fontQueries() > queries);
+
+    QFont scaledFont = newFont;
+    scaledFont.setPixelSize(20);
+    QCOMPARE(settings.fontMetrics(2).height(), QFontMetricsF(scaledFont).height());
+    QCOMPARE(settings.fontMetrics(1).height(), settings.fontMetrics().height());
+}
+
 QTEST_MAIN(DecorationTest)
 #include "decorationtest.moc"
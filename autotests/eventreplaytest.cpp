@@ -0,0 +1,100 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#include "../src/decorationsettings.h"
+#include "../src/private/decorationeventrecorder.h"
+#include "mockbridge.h"
+#include "mockbutton.h"
+#include "mockdecoration.h"
+#include "mockwindow.h"
+#include <QBuffer>
+#include <QSignalSpy>
+#include <QTest>
+
+class EventReplayTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testReplay();
+    void testInvalid();
+};
+
+void EventReplayTest::testReplay()
+{
+    auto setup = [](MockBridge &bridge, MockDecoration &deco, MockButton &button) {
+        deco.setSettings(std::make_shared<KDecoration3::DecorationSettings>(&bridge));
+        MockWindow *client = bridge.lastCreatedWindow();
+        client->setWidth(100);
+        client->setHeight(100);
+        deco.setBorders(QMargins(4, 24, 4, 4));
+        button.setGeometry(QRectF(10, 2, 20, 20));
+    };
+
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    MockButton button(KDecoration3::DecorationButtonType::Custom, &deco);
+    setup(bridge, deco, button);
+    QSignalSpy damagedSpy(&deco, &KDecoration3::Decoration::damaged);
+    QSignalSpy clickedSpy(&button, &KDecoration3::DecorationButton::clicked);
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    KDecoration3::DecorationEventRecorder recorder(&buffer);
+    recorder.record(&deco);
+
+    auto send = [&deco](QEvent &&event) {
+        QCoreApplication::sendEvent(&deco, &event);
+    };
+    send(QHoverEvent(QEvent::HoverEnter, QPointF(1, 1), QPointF(1, 1), QPointF(-1, -1)));
+    for (int x = 1; x < 40; x += 3) {
+        send(QHoverEvent(QEvent::HoverMove, QPointF(x, 10), QPointF(x, 10), QPointF(x - 3, 10)));
+    }
+    send(QHoverEvent(QEvent::HoverMove, QPointF(15, 10), QPointF(15, 10), QPointF(40, 10)));
+    send(QMouseEvent(QEvent::MouseButtonPress, QPointF(15, 10), QPointF(15, 10), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier));
+    send(QMouseEvent(QEvent::MouseButtonRelease, QPointF(15, 10), QPointF(15, 10), Qt::LeftButton, Qt::NoButton, Qt::NoModifier));
+    send(QWheelEvent(QPointF(15, 10), QPointF(15, 10), QPoint(), QPoint(0, 120), Qt::NoButton, Qt::NoModifier, Qt::NoScrollPhase, false));
+    send(QHoverEvent(QEvent::HoverLeave, QPointF(-1, -1), QPointF(-1, -1), QPointF(15, 10)));
+    recorder.stop(&deco);
+    const int recordedDamage = damagedSpy.count();
+    send(QHoverEvent(QEvent::HoverEnter, QPointF(1, 1), QPointF(1, 1), QPointF(-1, -1)));
+
+    QCOMPARE(recorder.recordedEvents(), 19);
+    QCOMPARE(clickedSpy.count(), 1);
+    QVERIFY(recordedDamage > 0);
+    buffer.close();
+
+    // replaying the recording against a new decoration reproduces the session
+    MockBridge replayBridge;
+    MockDecoration replayDeco(&replayBridge);
+    MockButton replayButton(KDecoration3::DecorationButtonType::Custom, &replayDeco);
+    setup(replayBridge, replayDeco, replayButton);
+    QSignalSpy replayDamagedSpy(&replayDeco, &KDecoration3::Decoration::damaged);
+    QSignalSpy replayClickedSpy(&replayButton, &KDecoration3::DecorationButton::clicked);
+
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    KDecoration3::DecorationEventPlayer player(&buffer);
+    QVERIFY(player.isValid());
+    const auto statistics = player.play(&replayDeco);
+    QCOMPARE(statistics.events, 19);
+    QVERIFY(statistics.elapsedNanoseconds > 0);
+    QCOMPARE(replayClickedSpy.count(), 1);
+    QCOMPARE(replayDamagedSpy.count(), recordedDamage);
+}
+
+void EventReplayTest::testInvalid()
+{
+    QByteArray data("not a recording");
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    KDecoration3::DecorationEventPlayer player(&buffer);
+    QVERIFY(!player.isValid());
+
+    MockBridge bridge;
+    MockDecoration deco(&bridge);
+    QCOMPARE(player.play(&deco).events, 0);
+}
+
+QTEST_MAIN(EventReplayTest)
+#include "eventreplaytest.moc"
@@ -0,0 +1,165 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#include "../src/decorationsettings.h"
+#include "allocationcounter.h"
+#include "mockbridge.h"
+#include "mockbutton.h"
+#include "mockdecoration.h"
+#include "mockwindow.h"
+#include <QSignalSpy>
+#include <QTest>
+
+class HoverDispatchTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testDirectDispatch();
+    void testHoverMoveAllocations_data();
+    void testHoverMoveAllocations();
+    void testTransitionAllocations();
+};
+
+static void hoverMove(MockDecoration *deco, const QPointF &pos)
+{
+    QHoverEvent event(QEvent::HoverMove, pos, pos, QPointF());
+    QCoreApplication::sendEvent(deco, &event);
+}
+
+void HoverDispatchTest::testDirectDispatch()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(4, 24, 4, 4));
+    QCOMPARE(deco.isDirectHoverDispatchEnabled(), false);
+    deco.setDirectHoverDispatchEnabled(true);
+    QCOMPARE(deco.isDirectHoverDispatchEnabled(), true);
+
+    MockButton button(KDecoration3::DecorationButtonType::Custom, &deco);
+    button.setGeometry(QRectF(10, 2, 20, 20));
+    MockButton disabledButton(KDecoration3::DecorationButtonType::Custom, &deco);
+    disabledButton.setGeometry(QRectF(40, 2, 20, 20));
+    disabledButton.setEnabled(false);
+    QSignalSpy enteredSpy(&button, &KDecoration3::DecorationButton::pointerEntered);
+    QSignalSpy leftSpy(&button, &KDecoration3::DecorationButton::pointerLeft);
+
+    hoverMove(&deco, QPointF(15, 10));
+    QCOMPARE(button.isHovered(), true);
+    QCOMPARE(enteredSpy.count(), 1);
+    hoverMove(&deco, QPointF(16, 10));
+    QCOMPARE(enteredSpy.count(), 1);
+    hoverMove(&deco, QPointF(45, 10));
+    QCOMPARE(button.isHovered(), false);
+    QCOMPARE(disabledButton.isHovered(), false);
+    QCOMPARE(leftSpy.count(), 1);
+
+    // entering and leaving the decoration
+    QHoverEvent enter(QEvent::HoverEnter, QPointF(15, 10), QPointF(15, 10), QPointF());
+    QCoreApplication::sendEvent(&deco, &enter);
+    QCOMPARE(button.isHovered(), true);
+    QHoverEvent leave(QEvent::HoverLeave, QPointF(-1, -1), QPointF(-1, -1), QPointF(15, 10));
+    QCoreApplication::sendEvent(&deco, &leave);
+    QCOMPARE(button.isHovered(), false);
+
+    // press and release still work on directly hovered buttons
+    QSignalSpy clickedSpy(&button, &KDecoration3::DecorationButton::clicked);
+    hoverMove(&deco, QPointF(15, 10));
+    QMouseEvent press(QEvent::MouseButtonPress, QPointF(15, 10), QPointF(15, 10), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &press);
+    QCOMPARE(button.isPressed(), true);
+    QMouseEvent release(QEvent::MouseButtonRelease, QPointF(15, 10), QPointF(15, 10), Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    QCoreApplication::sendEvent(&deco, &release);
+    QCOMPARE(clickedSpy.count(), 1);
+}
+
+void HoverDispatchTest::testHoverMoveAllocations_data()
+{
+    QTest::addColumn<bool>("direct");
+
+    QTest::newRow("events") << false;
+    QTest::newRow("direct") << true;
+}
+
+void HoverDispatchTest::testHoverMoveAllocations()
+{
+    MockBridge bridge;
+    auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+    MockDecoration deco(&bridge);
+    deco.setSettings(decoSettings);
+    MockWindow *client = bridge.lastCreatedWindow();
+    client->setWidth(100);
+    client->setHeight(100);
+    deco.setBorders(QMargins(4, 24, 4, 4));
+    QFETCH(bool, direct);
+    deco.setDirectHoverDispatchEnabled(direct);
+
+    MockButton button(KDecoration3::DecorationButtonType::Custom, &deco);
+    button.setGeometry(QRectF(10, 2, 20, 20));
+
+    // warm up the hit test caches, then move without changing the hovered buttons
+    QHoverEvent outside(QEvent::HoverMove, QPointF(50, 10), QPointF(50, 10), QPointF());
+    QHoverEvent inside(QEvent::HoverMove, QPointF(15, 10), QPointF(15, 10), QPointF());
+    QCoreApplication::sendEvent(&deco, &outside);
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 100; ++i) {
+            QCoreApplication::sendEvent(&deco, &outside);
+        }
+        QCOMPARE(counter.allocations(), 0);
+    }
+
+    QCoreApplication::sendEvent(&deco, &inside);
+    QCOMPARE(button.isHovered(), true);
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 100; ++i) {
+            QCoreApplication::sendEvent(&deco, &inside);
+        }
+        QCOMPARE(counter.allocations(), 0);
+    }
+}
+
+void HoverDispatchTest::testTransitionAllocations()
+{
+    auto countTransitionAllocations = [](bool direct) {
+        MockBridge bridge;
+        auto decoSettings = std::make_shared<KDecoration3::DecorationSettings>(&bridge);
+        MockDecoration deco(&bridge);
+        deco.setSettings(decoSettings);
+        MockWindow *client = bridge.lastCreatedWindow();
+        client->setWidth(100);
+        client->setHeight(100);
+        deco.setBorders(QMargins(4, 24, 4, 4));
+        deco.setDirectHoverDispatchEnabled(direct);
+
+        MockButton button(KDecoration3::DecorationButtonType::Custom, &deco);
+        button.setGeometry(QRectF(10, 2, 20, 20));
+
+        QHoverEvent outside(QEvent::HoverMove, QPointF(50, 10), QPointF(50, 10), QPointF());
+        QHoverEvent inside(QEvent::HoverMove, QPointF(15, 10), QPointF(15, 10), QPointF());
+        QCoreApplication::sendEvent(&deco, &inside);
+        QCoreApplication::sendEvent(&deco, &outside);
+        deco.takeDamage();
+
+        AllocationCounter counter;
+        QCoreApplication::sendEvent(&deco, &inside);
+        QCoreApplication::sendEvent(&deco, &outside);
+        return counter.allocations();
+    };
+
+    // the direct dispatch does not need to construct hover events for the buttons, entering and
+    // leaving the button only repaints it and updates the list of hovered buttons
+    const int direct = countTransitionAllocations(true);
+    QVERIFY(direct < countTransitionAllocations(false));
+    QVERIFY2(direct <= 6, qPrintable(QStringLiteral("%1 allocations").arg(direct)));
+}
+
+QTEST_MAIN(HoverDispatchTest)
+#include "hoverdispatchtest.moc"
@@ -46,7 +46,7 @@ bool MockDecoration::init()
 void MockDecoration::paint(QPainter *painter, const QRectF &repaintRegion)
 {
     Q_UNUSED(painter)
-    Q_UNUSED(repaintRegion)
+    paintedRects << repaintRegion;
 }
 
 void MockDecoration::setOpaque(bool set)
@@ -22,4 +22,8 @@ public:
     void setBorders(const QMargins &m);
     using Decoration::setTitleBar;
     void setTitleBar(const QRect &rect);
+    using Decoration::setBorderOutline;
+    using Decoration::setBorderRadius;
+
+    QList<QRectF> paintedRects;
 };
@@ -72,3 +72,20 @@ void MockSettings::setAlwaysShowExcludeFromCapture(bool set)
     m_alwaysShowExcludeFromCapture = set;
     Q_EMIT decorationSettings()->alwaysShowExcludeFromCaptureChanged(m_alwaysShowExcludeFromCapture);
 }
+
+QFont MockSettings::font() const
+{
+    m_fontQueries++;
+    return m_font.value_or(DecorationSettingsPrivateV2::font());
+}
+
+void MockSettings::setFont(const QFont &font)
+{
+    m_font = font;
+    Q_EMIT decorationSettings()->fontChanged(font);
+}
+
+int MockSettings::fontQueries() const
+{
+    return m_fontQueries;
+}
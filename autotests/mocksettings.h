@@ -7,6 +7,8 @@
 
 #include "../src/private/decorationsettingsprivate.h"
 
+#include <optional>
+
 class MockSettings : public KDecoration3::DecorationSettingsPrivateV2
 {
 public:
@@ -19,13 +21,18 @@ public:
     bool isCloseOnDoubleClickOnMenu() const override;
     bool isOnAllDesktopsAvailable() const override;
     bool isAlwaysShowExcludeFromCapture() const override;
+    QFont font() const override;
 
     void setOnAllDesktopsAvailabe(bool set);
     void setCloseOnDoubleClickOnMenu(bool set);
     void setAlwaysShowExcludeFromCapture(bool set);
+    void setFont(const QFont &font);
+    int fontQueries() const;
 
 private:
     bool m_onAllDesktopsAvailable = false;
     bool m_closeDoubleClickOnMenu = false;
     bool m_alwaysShowExcludeFromCapture = false;
+    std::optional<QFont> m_font;
+    mutable int m_fontQueries = 0;
 };
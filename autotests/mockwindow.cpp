@@ -222,11 +222,17 @@ void MockWindow::requestToggleShade()
 
 void MockWindow::requestShowToolTip(const QString &text)
 {
-    Q_UNUSED(text);
+    m_toolTip = text;
 }
 
 void MockWindow::requestHideToolTip()
 {
+    m_toolTip.clear();
+}
+
+QString MockWindow::toolTip() const
+{
+    return m_toolTip;
 }
 
 QSizeF MockWindow::size() const
@@ -298,7 +304,13 @@ qreal MockWindow::scale() const
 
 qreal MockWindow::nextScale() const
 {
-    return 1;
+    return m_nextScale;
+}
+
+void MockWindow::setNextScale(qreal scale)
+{
+    m_nextScale = scale;
+    Q_EMIT window()->nextScaleChanged();
 }
 
 QString MockWindow::applicationMenuServiceName() const
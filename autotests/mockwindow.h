@@ -70,6 +70,9 @@ public:
 
     void setWidth(int w);
     void setHeight(int h);
+    void setNextScale(qreal scale);
+
+    QString toolTip() const;
 
 Q_SIGNALS:
     void closeRequested();
@@ -93,4 +96,6 @@ private:
     bool m_onAllDesktops = false;
     qreal m_width = 0;
     qreal m_height = 0;
+    qreal m_nextScale = 1;
+    QString m_toolTip;
 };
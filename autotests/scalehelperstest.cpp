@@ -0,0 +1,232 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#include "../src/scalehelpers.h"
+#include <QTest>
+
+#include <limits>
+
+using namespace KDecoration3;
+
+class ScaleHelpersTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testMargins();
+    void testBorderRadius();
+    void testIntegralScale();
+    void testBatch_data();
+    void testBatch();
+    void benchmarkScalar_data();
+    void benchmarkScalar();
+    void benchmarkBatch_data();
+    void benchmarkBatch();
+    void benchmarkEdges_data();
+    void benchmarkEdges();
+};
+
+static QList<QRectF> makeRects(int count)
+{
+    QList<QRectF> rects;
+    rects.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        rects.append(QRectF(i * 0.37, i * 0.11, 20.3 + i % 7, 18.6 + i % 5));
+    }
+    return rects;
+}
+
+/**
+ * Whether the batch result @p actual matches the scalar result @p expected within the documented
+ * tolerance of two units in the last place. For power of two scales they must be identical.
+ **/
+static bool matchesScalar(qreal actual, qreal expected, qreal scale)
+{
+    if (std::exp2(std::round(std::log2(scale))) == scale) {
+        return actual == expected;
+    }
+    return std::abs(actual - expected) <= 2 * std::numeric_limits<qreal>::epsilon() * std::abs(expected);
+}
+
+void ScaleHelpersTest::testMargins()
+{
+    QCOMPARE(snapToPixelGrid(QMarginsF(1.2, 2.4, 3.6, 4.8), 1.0), QMarginsF(1, 2, 4, 5));
+    QCOMPARE(snapToPixelGrid(QMarginsF(1.2, 2.4, 3.6, 4.8), 2.0), QMarginsF(1, 2.5, 3.5, 5));
+}
+
+void ScaleHelpersTest::testBorderRadius()
+{
+    QCOMPARE(snapToPixelGrid(BorderRadius(1.2, 2.4, 3.6, 4.8), 1.0), BorderRadius(1, 2, 4, 5));
+    QCOMPARE(snapToPixelGrid(BorderRadius(1.2, 2.4, 3.6, 4.8), 2.0), BorderRadius(1, 2.5, 3.5, 5));
+}
+
+void ScaleHelpersTest::testIntegralScale()
+{
+    static_assert(snapToPixelGrid<1>(1.5) == 2.0);
+    static_assert(snapToPixelGrid<1>(-1.5) == -2.0);
+    static_assert(snapToPixelGrid<2>(1.3) == 1.5);
+    static_assert(snapToPixelGrid<2>(QPointF(0.2, 0.3)).x() == 0.0);
+    static_assert(snapToPixelGrid<2>(QPointF(0.2, 0.3)).y() == 0.5);
+
+    // the integer rounding must match std::round, the runtime variant uses it for integral scales
+    for (int i = -1000; i < 1000; ++i) {
+        const qreal value = i * 0.137;
+        for (const qreal scale : {1.0, 2.0, 3.0}) {
+            const qreal expected = std::round(value * scale) / scale;
+            QCOMPARE(snapToPixelGrid(value, scale), expected);
+            QCOMPARE(std::signbit(snapToPixelGrid(value, scale)), std::signbit(expected));
+        }
+        QCOMPARE(snapToPixelGrid<3>(value), snapToPixelGrid(value, 3.0));
+    }
+
+    // values which don't fit into an integer are passed through
+    QVERIFY(std::isnan(snapToPixelGrid<2>(qQNaN())));
+    QCOMPARE(snapToPixelGrid<2>(qInf()), qInf());
+    QCOMPARE(snapToPixelGrid<1>(-qInf()), -qInf());
+    QCOMPARE(snapToPixelGrid<2>(1e300), 1e300);
+    QCOMPARE(snapToPixelGrid<3>(-1e20), std::round(-1e20 * 3.0) / 3.0);
+
+    const QRectF rect(0.3, 0.6, 10.2, 20.7);
+    QCOMPARE(snapToPixelGrid<2>(rect), snapToPixelGrid(rect, 2.0));
+    QCOMPARE(snapToPixelGrid<2>(rect.size()), snapToPixelGrid(rect.size(), 2.0));
+    QCOMPARE(snapToPixelGrid<2>(QMarginsF(0.3, 0.6, 10.2, 20.7)), snapToPixelGrid(QMarginsF(0.3, 0.6, 10.2, 20.7), 2.0));
+}
+
+void ScaleHelpersTest::testBatch_data()
+{
+    QTest::addColumn<qreal>("scale");
+
+    QTest::newRow("1") << 1.0;
+    QTest::newRow("1.25") << 1.25;
+    QTest::newRow("1.5") << 1.5;
+    QTest::newRow("2") << 2.0;
+}
+
+void ScaleHelpersTest::testBatch()
+{
+    QFETCH(qreal, scale);
+
+    // the batch variants must match the scalar ones
+    QList<QRectF> rects = makeRects(100);
+    QList<qreal> values;
+    QList<QMarginsF> margins;
+    QList<BorderRadius> radii;
+    for (const QRectF &rect : std::as_const(rects)) {
+        values.append(rect.x());
+        margins.append(QMarginsF(rect.x(), rect.y(), rect.width(), rect.height()));
+        radii.append(BorderRadius(rect.x(), rect.y(), rect.width(), rect.height()));
+    }
+    const QList<QRectF> expectedRects = rects;
+    const QList<qreal> expectedValues = values;
+    const QList<QMarginsF> expectedMargins = margins;
+    const QList<BorderRadius> expectedRadii = radii;
+
+    QList<qreal> lefts;
+    QList<qreal> tops;
+    QList<qreal> rights;
+    QList<qreal> bottoms;
+    for (const QRectF &rect : std::as_const(rects)) {
+        lefts.append(rect.left());
+        tops.append(rect.top());
+        rights.append(rect.right());
+        bottoms.append(rect.bottom());
+    }
+
+    snapToPixelGrid(std::span<QRectF>(rects), scale);
+    snapToPixelGrid(std::span<qreal>(values), scale);
+    snapToPixelGrid(std::span<QMarginsF>(margins), scale);
+    snapToPixelGrid(std::span<BorderRadius>(radii), scale);
+    snapToPixelGrid(std::span<qreal>(lefts), std::span<qreal>(tops), std::span<qreal>(rights), std::span<qreal>(bottoms), scale);
+    for (int i = 0; i < rects.count(); ++i) {
+        const QRectF rect = snapToPixelGrid(expectedRects[i], scale);
+        QVERIFY(matchesScalar(rects[i].left(), rect.left(), scale));
+        QVERIFY(matchesScalar(rects[i].top(), rect.top(), scale));
+        QVERIFY(matchesScalar(rects[i].right(), rect.right(), scale));
+        QVERIFY(matchesScalar(rects[i].bottom(), rect.bottom(), scale));
+        QVERIFY(matchesScalar(lefts[i], rect.left(), scale));
+        QVERIFY(matchesScalar(tops[i], rect.top(), scale));
+        QVERIFY(matchesScalar(rights[i], rect.right(), scale));
+        QVERIFY(matchesScalar(bottoms[i], rect.bottom(), scale));
+        QVERIFY(matchesScalar(values[i], snapToPixelGrid(expectedValues[i], scale), scale));
+        const QMarginsF margin = snapToPixelGrid(expectedMargins[i], scale);
+        QVERIFY(matchesScalar(margins[i].left(), margin.left(), scale));
+        QVERIFY(matchesScalar(margins[i].top(), margin.top(), scale));
+        QVERIFY(matchesScalar(margins[i].right(), margin.right(), scale));
+        QVERIFY(matchesScalar(margins[i].bottom(), margin.bottom(), scale));
+        const BorderRadius radius = snapToPixelGrid(expectedRadii[i], scale);
+        QVERIFY(matchesScalar(radii[i].topLeft(), radius.topLeft(), scale));
+        QVERIFY(matchesScalar(radii[i].topRight(), radius.topRight(), scale));
+        QVERIFY(matchesScalar(radii[i].bottomRight(), radius.bottomRight(), scale));
+        QVERIFY(matchesScalar(radii[i].bottomLeft(), radius.bottomLeft(), scale));
+    }
+}
+
+void ScaleHelpersTest::benchmarkScalar_data()
+{
+    testBatch_data();
+}
+
+void ScaleHelpersTest::benchmarkScalar()
+{
+    QFETCH(qreal, scale);
+
+    // like the batch variant, snap a fresh copy of the input in every iteration
+    const QList<QRectF> source = makeRects(10000);
+    QList<QRectF> rects(source.count());
+    QBENCHMARK {
+        std::copy(source.cbegin(), source.cend(), rects.begin());
+        for (QRectF &rect : rects) {
+            rect = snapToPixelGrid(rect, scale);
+        }
+    }
+}
+
+void ScaleHelpersTest::benchmarkBatch_data()
+{
+    testBatch_data();
+}
+
+void ScaleHelpersTest::benchmarkBatch()
+{
+    QFETCH(qreal, scale);
+
+    const QList<QRectF> source = makeRects(10000);
+    QList<QRectF> rects(source.count());
+    QBENCHMARK {
+        std::copy(source.cbegin(), source.cend(), rects.begin());
+        snapToPixelGrid(std::span<QRectF>(rects), scale);
+    }
+}
+
+void ScaleHelpersTest::benchmarkEdges_data()
+{
+    testBatch_data();
+}
+
+void ScaleHelpersTest::benchmarkEdges()
+{
+    QFETCH(qreal, scale);
+
+    const QList<QRectF> source = makeRects(10000);
+    QList<qreal> sourceEdges[4];
+    for (const QRectF &rect : source) {
+        sourceEdges[0].append(rect.left());
+        sourceEdges[1].append(rect.top());
+        sourceEdges[2].append(rect.right());
+        sourceEdges[3].append(rect.bottom());
+    }
+    QList<qreal> edges[4];
+    for (QList<qreal> &values : edges) {
+        values.resize(source.count());
+    }
+    QBENCHMARK {
+        for (int i = 0; i < 4; ++i) {
+            std::copy(sourceEdges[i].cbegin(), sourceEdges[i].cend(), edges[i].begin());
+        }
+        snapToPixelGrid(std::span<qreal>(edges[0]), std::span<qreal>(edges[1]), std::span<qreal>(edges[2]), std::span<qreal>(edges[3]), scale);
+    }
+}
+
+QTEST_MAIN(ScaleHelpersTest)
+#include "scalehelperstest.moc"
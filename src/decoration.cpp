@@ -7,14 +7,26 @@
 #include "decoratedwindow.h"
 #include "decoration_p.h"
 #include "decorationbutton.h"
+#include "decorationbutton_p.h"
+#include "decorationbuttongroup.h"
+#include "decorationbuttongroup_p.h"
+#include "decorationrendercache_p.h"
 #include "decorationsettings.h"
+#include "decorationtracing_p.h"
 #include "private/decoratedwindowprivate.h"
 #include "private/decorationbridge.h"
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QHoverEvent>
+#include <QTimer>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <limits>
+#include <utility>
 
 namespace KDecoration3
 {
@@ -29,6 +41,57 @@ DecorationBridge *findBridge(const QVariantList &args)
     }
     Q_UNREACHABLE();
 }
+
+/**
+ * Returns the largest integer rect that is fully inside @p rect.
+ **/
+QRect innerAlignedRect(const QRectF &rect)
+{
+    const QPoint topLeft(std::ceil(rect.left()), std::ceil(rect.top()));
+    const QPoint bottomRight(std::floor(rect.right()) - 1, std::floor(rect.bottom()) - 1);
+    return QRect(topLeft, bottomRight);
+}
+
+/**
+ * Returns the area between the outer edge of @p rect and the inner edge of the given @p margins.
+ **/
+QRegion frameRegion(const QRectF &rect, const QMarginsF &margins)
+{
+    const QRect inner = innerAlignedRect(rect.marginsRemoved(margins));
+    if (inner.isEmpty()) {
+        return QRegion(rect.toAlignedRect());
+    }
+    return QRegion(rect.toAlignedRect()) - QRegion(inner);
+}
+
+/**
+ * Returns the corners of @p rect affected by a change from the @p previous to the @p next radius.
+ **/
+QRegion cornerRegion(const QRectF &rect, const QMarginsF &margins, const BorderRadius &previous, const BorderRadius &next)
+{
+    QRegion region;
+    if (previous.topLeft() != next.topLeft()) {
+        const qreal radius = std::max(previous.topLeft(), next.topLeft());
+        region += QRectF(rect.left(), rect.top(), margins.left() + radius, margins.top() + radius).toAlignedRect();
+    }
+    if (previous.topRight() != next.topRight()) {
+        const qreal radius = std::max(previous.topRight(), next.topRight());
+        const qreal width = margins.right() + radius;
+        region += QRectF(rect.right() - width, rect.top(), width, margins.top() + radius).toAlignedRect();
+    }
+    if (previous.bottomRight() != next.bottomRight()) {
+        const qreal radius = std::max(previous.bottomRight(), next.bottomRight());
+        const qreal width = margins.right() + radius;
+        const qreal height = margins.bottom() + radius;
+        region += QRectF(rect.right() - width, rect.bottom() - height, width, height).toAlignedRect();
+    }
+    if (previous.bottomLeft() != next.bottomLeft()) {
+        const qreal radius = std::max(previous.bottomLeft(), next.bottomLeft());
+        const qreal height = margins.bottom() + radius;
+        region += QRectF(rect.left(), rect.bottom() - height, margins.left() + radius, height).toAlignedRect();
+    }
+    return region;
+}
 }
 
 BorderRadius::BorderRadius()
@@ -102,11 +165,22 @@ BorderRadius BorderOutline::radius() const
 class DecorationStateData : public QSharedData
 {
 public:
+    static quint64 nextGeneration();
+
     QMarginsF borders;
     BorderRadius borderRadius;
     BorderOutline borderOutline;
+    quint64 generation = 0;
+    // the generation in which each field has been modified last, indexed by the bit of the field
+    std::array<quint64, 4> fieldGenerations = {};
 };
 
+quint64 DecorationStateData::nextGeneration()
+{
+    static std::atomic<quint64> generation = 0;
+    return ++generation;
+}
+
 DecorationState::DecorationState()
     : d(new DecorationStateData)
 {
@@ -133,7 +207,11 @@ QMarginsF DecorationState::borders() const
 
 void DecorationState::setBorders(const QMarginsF &borders)
 {
+    if (d.constData()->borders == borders) {
+        return;
+    }
     d->borders = borders;
+    markDirty(Field::Borders);
 }
 
 BorderRadius DecorationState::borderRadius() const
@@ -143,7 +221,11 @@ BorderRadius DecorationState::borderRadius() const
 
 void DecorationState::setBorderRadius(const BorderRadius &radius)
 {
+    if (d.constData()->borderRadius == radius) {
+        return;
+    }
     d->borderRadius = radius;
+    markDirty(Field::BorderRadius);
 }
 
 BorderOutline DecorationState::borderOutline() const
@@ -153,7 +235,69 @@ BorderOutline DecorationState::borderOutline() const
 
 void DecorationState::setBorderOutline(const BorderOutline &outline)
 {
+    if (d.constData()->borderOutline == outline) {
+        return;
+    }
     d->borderOutline = outline;
+    markDirty(Field::BorderOutline);
+}
+
+quint64 DecorationState::generation() const
+{
+    return d->generation;
+}
+
+DecorationState::Fields DecorationState::changedFields(const DecorationState &other) const
+{
+    Fields fields;
+    if (d == other.d) {
+        return fields;
+    }
+    for (size_t i = 0; i < d->fieldGenerations.size(); ++i) {
+        if (d->fieldGenerations[i] != other.d->fieldGenerations[i]) {
+            fields |= Field(1 << i);
+        }
+    }
+    return fields;
+}
+
+void DecorationState::markDirty(Fields fields)
+{
+    const quint64 generation = DecorationStateData::nextGeneration();
+    d->generation = generation;
+    for (size_t i = 0; i < d->fieldGenerations.size(); ++i) {
+        if (fields.testFlag(Field(1 << i))) {
+            d->fieldGenerations[i] = generation;
+        }
+    }
+}
+
+DecorationSnapshot::DecorationSnapshot(const std::shared_ptr<const DecorationState> &state, const QSizeF &size, const QRectF &titleBar, qreal scale)
+    : m_state(state)
+    , m_size(size)
+    , m_titleBar(titleBar)
+    , m_scale(scale)
+{
+}
+
+std::shared_ptr<const DecorationState> DecorationSnapshot::state() const
+{
+    return m_state;
+}
+
+QSizeF DecorationSnapshot::size() const
+{
+    return m_size;
+}
+
+QRectF DecorationSnapshot::titleBar() const
+{
+    return m_titleBar;
+}
+
+qreal DecorationSnapshot::scale() const
+{
+    return m_scale;
 }
 
 Positioner::Positioner()
@@ -180,6 +324,66 @@ void Positioner::setAnchorRect(const QRectF &rect)
     d->anchorRect = rect;
 }
 
+DecorationStatistics::DecorationStatistics()
+    : d(new DecorationStatisticsData)
+{
+}
+
+DecorationStatistics::DecorationStatistics(const DecorationStatistics &other)
+    : d(other.d)
+{
+}
+
+DecorationStatistics::~DecorationStatistics()
+{
+}
+
+DecorationStatistics &DecorationStatistics::operator=(const DecorationStatistics &other)
+{
+    d = other.d;
+    return *this;
+}
+
+quint64 DecorationStatistics::damagedEmissions() const
+{
+    return d->damagedEmissions;
+}
+
+quint64 DecorationStatistics::damagedArea() const
+{
+    return d->damagedArea;
+}
+
+quint64 DecorationStatistics::hoverEvents() const
+{
+    return d->hoverEvents;
+}
+
+quint64 DecorationStatistics::mouseEvents() const
+{
+    return d->mouseEvents;
+}
+
+quint64 DecorationStatistics::forwardedButtonEvents() const
+{
+    return d->forwardedButtonEvents;
+}
+
+quint64 DecorationStatistics::stateApplies() const
+{
+    return d->stateApplies;
+}
+
+quint64 DecorationStatistics::layoutPasses() const
+{
+    return d->layoutPasses;
+}
+
+qint64 DecorationStatistics::renderCachePaintTime() const
+{
+    return d->renderCachePaintTime;
+}
+
 Decoration::Private::Private(Decoration *deco, const QVariantList &args)
     : sectionUnderMouse(Qt::NoSection)
     , bridge(findBridge(args))
@@ -193,6 +397,48 @@ Decoration::Private::Private(Decoration *deco, const QVariantList &args)
             style = it->value<Style>();
         }
     }
+    auto geometryChanged = [this] {
+        invalidateSectionMap();
+        publishSnapshot();
+    };
+    QObject::connect(client.get(), &DecoratedWindow::widthChanged, q, geometryChanged);
+    QObject::connect(client.get(), &DecoratedWindow::heightChanged, q, geometryChanged);
+    QObject::connect(client.get(), &DecoratedWindow::sizeChanged, q, geometryChanged);
+    QObject::connect(client.get(), &DecoratedWindow::shadedChanged, q, geometryChanged);
+    QObject::connect(client.get(), &DecoratedWindow::scaleChanged, q, [this] {
+        publishSnapshot();
+    });
+}
+
+void Decoration::Private::publishSnapshot()
+{
+    if (!current) {
+        return;
+    }
+    if (!snapshotState) {
+        // the clone shares the data with the current state, but it can't be modified by anyone
+        snapshotState = current->clone();
+    }
+    // an interactive resize publishes a snapshot per size change, recycle the previous snapshot
+    // instead of allocating a new one. Readers can only acquire the published snapshot, so once
+    // the previous one is not referenced anymore, nobody can see it being overwritten.
+    std::shared_ptr<DecorationSnapshot> next = std::exchange(spareSnapshot, nullptr);
+    if (next && next.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        *next = DecorationSnapshot(snapshotState, q->size(), titleBar, client->scale());
+    } else {
+        next = std::make_shared<DecorationSnapshot>(snapshotState, q->size(), titleBar, client->scale());
+    }
+#if defined(__cpp_lib_atomic_shared_ptr)
+    snapshot.store(next, std::memory_order_release);
+#else
+    // the free functions are deprecated in C++20, but the only option without std::atomic<std::shared_ptr>
+    QT_WARNING_PUSH
+    QT_WARNING_DISABLE_DEPRECATED
+    std::atomic_store_explicit(&snapshot, std::shared_ptr<const DecorationSnapshot>(next), std::memory_order_release);
+    QT_WARNING_POP
+#endif
+    spareSnapshot = std::exchange(publishedSnapshot, std::move(next));
 }
 
 void Decoration::Private::setSectionUnderMouse(Qt::WindowFrameSection section)
@@ -206,82 +452,515 @@ void Decoration::Private::setSectionUnderMouse(Qt::WindowFrameSection section)
 
 void Decoration::Private::updateSectionUnderMouse(const QPoint &mousePosition)
 {
-    if (titleBar.toRect().contains(mousePosition)) {
-        setSectionUnderMouse(Qt::TitleBarArea);
+    updateSectionMap();
+    if (!sectionCell.contains(mousePosition)) {
+        sectionCell = sectionCellAt(mousePosition);
+        sectionCellSection = sectionAt(mousePosition);
+    }
+    setSectionUnderMouse(sectionCellSection);
+}
+
+void Decoration::Private::invalidateSectionMap()
+{
+    sectionMapDirty = true;
+    sectionCell = QRect();
+}
+
+void Decoration::Private::updateSectionMap()
+{
+    if (!sectionMapDirty) {
         return;
     }
+    sectionMapDirty = false;
+
+    // all comparisons are done with floored mouse positions, so ceiling the edges is exact
+    auto edge = [](qreal value) {
+        return int(std::ceil(value));
+    };
     const QSizeF size = q->size();
     const QMarginsF borders = current->borders();
     const int corner = 2 * settings->largeSpacing();
-    const bool left = mousePosition.x() < borders.left();
-    const bool top = mousePosition.y() < borders.top();
-    const bool bottom = mousePosition.y() >= size.height() - borders.bottom();
-    const bool right = mousePosition.x() >= size.width() - borders.right();
+
+    SectionMap &map = sectionMap;
+    map.titleBar = titleBar.toRect();
+    map.left = edge(borders.left());
+    map.right = edge(size.width() - borders.right());
+    map.top = edge(borders.top());
+    map.bottom = edge(size.height() - borders.bottom());
+    map.leftCorner = edge(borders.left() + corner);
+    map.rightCorner = edge(size.width() - borders.right() - corner);
+    map.topCorner = edge(titleBar.top() + corner);
+    map.bottomCorner = edge(size.height() - borders.bottom() - corner);
+    map.titleBarTop = edge(titleBar.top());
+    map.titleBarBottom = edge(titleBar.bottom());
+
+    // the section is constant inside each cell of the grid spanned by all edges
+    map.columns = {map.left, map.right, map.leftCorner, map.rightCorner};
+    map.rows = {map.top, map.bottom, map.topCorner, map.bottomCorner, map.titleBarTop, map.titleBarBottom};
+    if (!map.titleBar.isEmpty()) {
+        map.columns << map.titleBar.left() << map.titleBar.right() + 1;
+        map.rows << map.titleBar.top() << map.titleBar.bottom() + 1;
+    }
+    std::sort(map.columns.begin(), map.columns.end());
+    std::sort(map.rows.begin(), map.rows.end());
+}
+
+QRect Decoration::Private::sectionCellAt(const QPoint &pos) const
+{
+    auto band = [](const auto &edges, int value) {
+        const auto it = std::upper_bound(edges.cbegin(), edges.cend(), value);
+        const int from = it == edges.cbegin() ? std::numeric_limits<int>::min() / 2 : *(it - 1);
+        const int to = it == edges.cend() ? std::numeric_limits<int>::max() / 2 : *it;
+        return std::make_pair(from, to);
+    };
+    const auto [left, right] = band(sectionMap.columns, pos.x());
+    const auto [top, bottom] = band(sectionMap.rows, pos.y());
+    return QRect(QPoint(left, top), QPoint(right - 1, bottom - 1));
+}
+
+Qt::WindowFrameSection Decoration::Private::sectionAt(const QPoint &pos) const
+{
+    const SectionMap &map = sectionMap;
+    if (map.titleBar.contains(pos)) {
+        return Qt::TitleBarArea;
+    }
+    const bool left = pos.x() < map.left;
+    const bool top = pos.y() < map.top;
+    const bool bottom = pos.y() >= map.bottom;
+    const bool right = pos.x() >= map.right;
     if (left) {
-        if (top && mousePosition.y() < titleBar.top() + corner) {
-            setSectionUnderMouse(Qt::TopLeftSection);
-        } else if (mousePosition.y() >= size.height() - borders.bottom() - corner && mousePosition.y() >= titleBar.bottom()) {
-            setSectionUnderMouse(Qt::BottomLeftSection);
-        } else {
-            setSectionUnderMouse(Qt::LeftSection);
+        if (top && pos.y() < map.topCorner) {
+            return Qt::TopLeftSection;
+        } else if (pos.y() >= map.bottomCorner && pos.y() >= map.titleBarBottom) {
+            return Qt::BottomLeftSection;
         }
-        return;
+        return Qt::LeftSection;
     }
     if (right) {
-        if (top && mousePosition.y() < titleBar.top() + corner) {
-            setSectionUnderMouse(Qt::TopRightSection);
-        } else if (mousePosition.y() >= size.height() - borders.bottom() - corner && mousePosition.y() >= titleBar.bottom()) {
-            setSectionUnderMouse(Qt::BottomRightSection);
-        } else {
-            setSectionUnderMouse(Qt::RightSection);
+        if (top && pos.y() < map.topCorner) {
+            return Qt::TopRightSection;
+        } else if (pos.y() >= map.bottomCorner && pos.y() >= map.titleBarBottom) {
+            return Qt::BottomRightSection;
         }
-        return;
+        return Qt::RightSection;
     }
     if (bottom) {
-        if (mousePosition.y() >= titleBar.bottom()) {
-            if (mousePosition.x() < borders.left() + corner) {
-                setSectionUnderMouse(Qt::BottomLeftSection);
-            } else if (mousePosition.x() >= size.width() - borders.right() - corner) {
-                setSectionUnderMouse(Qt::BottomRightSection);
-            } else {
-                setSectionUnderMouse(Qt::BottomSection);
+        if (pos.y() >= map.titleBarBottom) {
+            if (pos.x() < map.leftCorner) {
+                return Qt::BottomLeftSection;
+            } else if (pos.x() >= map.rightCorner) {
+                return Qt::BottomRightSection;
             }
-        } else {
-            setSectionUnderMouse(Qt::TitleBarArea);
+            return Qt::BottomSection;
         }
-        return;
+        return Qt::TitleBarArea;
     }
     if (top) {
-        if (mousePosition.y() < titleBar.top()) {
-            if (mousePosition.x() < borders.left() + corner) {
-                setSectionUnderMouse(Qt::TopLeftSection);
-            } else if (mousePosition.x() >= size.width() - borders.right() - corner) {
-                setSectionUnderMouse(Qt::TopRightSection);
-            } else {
-                setSectionUnderMouse(Qt::TopSection);
+        if (pos.y() < map.titleBarTop) {
+            if (pos.x() < map.leftCorner) {
+                return Qt::TopLeftSection;
+            } else if (pos.x() >= map.rightCorner) {
+                return Qt::TopRightSection;
             }
-        } else {
-            setSectionUnderMouse(Qt::TitleBarArea);
+            return Qt::TopSection;
+        }
+        return Qt::TitleBarArea;
+    }
+    return Qt::NoSection;
+}
+
+void Decoration::Private::addDamage(const QRegion &region)
+{
+    if (statistics) {
+        for (const QRect &rect : region) {
+            statistics->damagedArea += quint64(rect.width()) * rect.height();
+        }
+    }
+    for (DecorationRenderCache *cache : std::as_const(renderCaches)) {
+        cache->d->markDirty(region);
+    }
+    if (!accumulateDamage) {
+        if (statistics) {
+            statistics->damagedEmissions++;
+        }
+        Q_EMIT q->damaged(region);
+        return;
+    }
+    damage += region;
+    if (!damageNotified) {
+        damageNotified = true;
+        if (statistics) {
+            statistics->damagedEmissions++;
+        }
+        Q_EMIT q->damaged(damage);
+    }
+}
+
+void Decoration::Private::sendToButton(DecorationButton *button, QEvent *event)
+{
+    if (statistics) {
+        statistics->forwardedButtonEvents++;
+    }
+    QCoreApplication::sendEvent(button, event);
+}
+
+void Decoration::Private::recordEvent(QEvent::Type type)
+{
+    switch (type) {
+    case QEvent::HoverEnter:
+    case QEvent::HoverLeave:
+    case QEvent::HoverMove:
+        statistics->hoverEvents++;
+        break;
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+        statistics->mouseEvents++;
+        break;
+    default:
+        break;
+    }
+}
+
+void Decoration::Private::enterButton(DecorationButton *button, QHoverEvent *event)
+{
+    if (directHoverDispatch) {
+        if (statistics) {
+            statistics->forwardedButtonEvents++;
         }
+        button->d->enter();
+    } else if (event->type() == QEvent::HoverEnter) {
+        sendToButton(button, event);
+    } else {
+        QHoverEvent e(QEvent::HoverEnter, event->position(), event->globalPosition(), event->oldPosF(), event->modifiers());
+        sendToButton(button, &e);
+    }
+}
+
+void Decoration::Private::leaveButton(DecorationButton *button, QHoverEvent *event)
+{
+    if (directHoverDispatch) {
+        if (statistics) {
+            statistics->forwardedButtonEvents++;
+        }
+        button->d->leave();
+    } else if (event->type() == QEvent::HoverLeave) {
+        sendToButton(button, event);
+    } else {
+        QHoverEvent e(QEvent::HoverLeave, event->position(), event->globalPosition(), event->oldPosF(), event->modifiers());
+        sendToButton(button, &e);
+    }
+}
+
+void Decoration::Private::queueHoverMove(QHoverEvent *event)
+{
+    if (pendingHover) {
+        // keep the position the first coalesced event started from
+        pendingHover->position = event->position();
+        pendingHover->globalPosition = event->globalPosition();
+        pendingHover->modifiers = event->modifiers();
+    } else {
+        pendingHover = PendingHover{
+            .position = event->position(),
+            .globalPosition = event->globalPosition(),
+            .oldPosition = event->oldPosF(),
+            .modifiers = event->modifiers(),
+        };
+    }
+    event->setAccepted(true);
+    // with damage accumulation the compositor flushes at the start of every frame with
+    // takeDamage(), the timer makes sure the position gets processed if no frame is painted
+    if (!hoverFlushTimer) {
+        hoverFlushTimer = std::make_unique<QTimer>();
+        hoverFlushTimer->setSingleShot(true);
+        hoverFlushTimer->setTimerType(Qt::PreciseTimer);
+        hoverFlushTimer->setInterval(hoverFlushInterval);
+        QObject::connect(hoverFlushTimer.get(), &QTimer::timeout, q, [this]() {
+            flushHover();
+        });
+    }
+    if (!hoverFlushTimer->isActive()) {
+        hoverFlushTimer->start();
+    }
+}
+
+void Decoration::Private::flushHover()
+{
+    if (!pendingHover) {
         return;
     }
-    setSectionUnderMouse(Qt::NoSection);
+    hoverFlushTimer->stop();
+    const PendingHover hover = *std::exchange(pendingHover, std::nullopt);
+    QHoverEvent event(QEvent::HoverMove, hover.position, hover.globalPosition, hover.oldPosition, hover.modifiers);
+    q->hoverMoveEvent(&event);
+}
+
+void Decoration::Private::paint(QPainter *painter, const QRectF &repaintArea)
+{
+    DecorationTraceSpan span(DecorationTracing::Span::Paint, q);
+    if (!statistics) {
+        q->paint(painter, repaintArea);
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    q->paint(painter, repaintArea);
+    statistics->renderCachePaintTime += timer.nsecsElapsed();
+}
+
+QRegion Decoration::Private::stateDamage(const DecorationState &previous, const DecorationState &next, DecorationState::Fields changed) const
+{
+    const QRectF rect = q->rect();
+    if (changed.testFlag(DecorationState::Field::Custom)) {
+        // something we don't know about changed, e.g. a property of a DecorationState sub-class
+        return QRegion(rect.toAlignedRect());
+    }
+    if (!changed) {
+        return QRegion();
+    }
+
+    const QMarginsF borders = next.borders();
+    if (changed.testFlag(DecorationState::Field::Borders)) {
+        // the size changes as well, so everything but the window contents needs a repaint
+        return frameRegion(rect, borders);
+    }
+
+    QRegion region;
+    if (changed.testFlag(DecorationState::Field::BorderRadius)) {
+        region += cornerRegion(rect, borders, previous.borderRadius(), next.borderRadius());
+    }
+    if (changed.testFlag(DecorationState::Field::BorderOutline)) {
+        const BorderOutline previousOutline = previous.borderOutline();
+        const BorderOutline nextOutline = next.borderOutline();
+        const qreal thickness = std::max(previousOutline.thickness(), nextOutline.thickness());
+        const QMarginsF band(thickness, thickness, thickness, thickness);
+        region += frameRegion(rect, band);
+        region += cornerRegion(rect, band, previousOutline.radius(), nextOutline.radius());
+    }
+    return region;
 }
 
 void Decoration::Private::addButton(DecorationButton *button)
 {
     Q_ASSERT(!buttons.contains(button));
     buttons << button;
-    QObject::connect(button, &QObject::destroyed, q, [this](QObject *o) {
-        auto it = buttons.begin();
-        while (it != buttons.end()) {
-            if (*it == static_cast<DecorationButton *>(o)) {
-                it = buttons.erase(it);
-            } else {
-                it++;
-            }
+    invalidateButtonIndex();
+    if (!buttonStatesConnected) {
+        buttonStatesConnected = true;
+        connectButtonStates();
+        connectButtonSettings();
+    }
+}
+
+void Decoration::Private::removeButton(DecorationButton *button)
+{
+    buttons.removeAll(button);
+    hoveredButtons.removeAll(button);
+    pressedButtons.removeAll(button);
+    invalidateButtonIndex();
+}
+
+template<typename Function>
+void Decoration::Private::forEachButton(DecorationButtonType type, Function function)
+{
+    // changing the state of a button may change the buttons of the decoration
+    const auto buttons = this->buttons;
+    for (DecorationButton *button : buttons) {
+        if (button->type() == type) {
+            function(button->d.get());
+        }
+    }
+}
+
+void Decoration::Private::setButtonState(DecorationButtonType type, DecorationButton::State state, bool set)
+{
+    forEachButton(type, [state, set](DecorationButton::Private *button) {
+        switch (state) {
+        case DecorationButton::State::Enabled:
+            button->setEnabled(set);
+            break;
+        case DecorationButton::State::Checked:
+            button->setChecked(set);
+            break;
+        case DecorationButton::State::Visible:
+            button->setVisible(set);
+            break;
+        default:
+            Q_UNREACHABLE();
+        }
+    });
+    for (DecorationButtonGroup *group : std::as_const(lightweightGroups)) {
+        group->d->setButtonState(type, state, set);
+    }
+}
+
+void Decoration::Private::connectButtonStates()
+{
+    using State = DecorationButton::State;
+    DecoratedWindow *c = client.get();
+    QObject::connect(c, &DecoratedWindow::hasApplicationMenuChanged, q, [this](bool has) {
+        setButtonState(DecorationButtonType::ApplicationMenu, State::Visible, has);
+    });
+    QObject::connect(c, &DecoratedWindow::applicationMenuActiveChanged, q, [this](bool active) {
+        setButtonState(DecorationButtonType::ApplicationMenu, State::Checked, active);
+    });
+    QObject::connect(c, &DecoratedWindow::onAllDesktopsChanged, q, [this](bool onAllDesktops) {
+        setButtonState(DecorationButtonType::OnAllDesktops, State::Checked, onAllDesktops);
+    });
+    QObject::connect(c, &DecoratedWindow::minimizeableChanged, q, [this](bool minimizeable) {
+        setButtonState(DecorationButtonType::Minimize, State::Enabled, minimizeable);
+    });
+    QObject::connect(c, &DecoratedWindow::maximizeableChanged, q, [this](bool maximizeable) {
+        setButtonState(DecorationButtonType::Maximize, State::Enabled, maximizeable);
+    });
+    QObject::connect(c, &DecoratedWindow::maximizedChanged, q, [this](bool maximized) {
+        setButtonState(DecorationButtonType::Maximize, State::Checked, maximized);
+    });
+    QObject::connect(c, &DecoratedWindow::closeableChanged, q, [this](bool closeable) {
+        setButtonState(DecorationButtonType::Close, State::Enabled, closeable);
+    });
+    QObject::connect(c, &DecoratedWindow::providesContextHelpChanged, q, [this](bool contextHelp) {
+        setButtonState(DecorationButtonType::ContextHelp, State::Visible, contextHelp);
+    });
+    QObject::connect(c, &DecoratedWindow::keepAboveChanged, q, [this](bool keepAbove) {
+        setButtonState(DecorationButtonType::KeepAbove, State::Checked, keepAbove);
+    });
+    QObject::connect(c, &DecoratedWindow::keepBelowChanged, q, [this](bool keepBelow) {
+        setButtonState(DecorationButtonType::KeepBelow, State::Checked, keepBelow);
+    });
+    QObject::connect(c, &DecoratedWindow::excludeFromCaptureChanged, q, [this](bool excluded) {
+        setButtonState(DecorationButtonType::ExcludeFromCapture, State::Checked, excluded);
+        setButtonState(DecorationButtonType::ExcludeFromCapture, State::Visible, settings->isAlwaysShowExcludeFromCapture() || excluded);
+    });
+    QObject::connect(c, &DecoratedWindow::shadedChanged, q, [this](bool shaded) {
+        setButtonState(DecorationButtonType::Shade, State::Checked, shaded);
+    });
+    QObject::connect(c, &DecoratedWindow::shadeableChanged, q, [this](bool shadeable) {
+        setButtonState(DecorationButtonType::Shade, State::Enabled, shadeable);
+    });
+}
+
+void Decoration::Private::connectButtonSettings()
+{
+    for (const QMetaObject::Connection &connection : std::as_const(buttonSettingsConnections)) {
+        QObject::disconnect(connection);
+    }
+    buttonSettingsConnections.clear();
+    if (!settings) {
+        return;
+    }
+    buttonSettingsConnections << QObject::connect(
+        settings.get(),
+        &DecorationSettings::closeOnDoubleClickOnMenuChanged,
+        q,
+        [this](bool enabled) {
+            forEachButton(DecorationButtonType::Menu, [enabled](DecorationButton::Private *button) {
+                button->doubleClickEnabled = enabled;
+                button->setPressAndHold(enabled);
+            });
+        },
+        Qt::QueuedConnection);
+    buttonSettingsConnections << QObject::connect(settings.get(), &DecorationSettings::onAllDesktopsAvailableChanged, q, [this](bool available) {
+        setButtonState(DecorationButtonType::OnAllDesktops, DecorationButton::State::Visible, available);
+    });
+    buttonSettingsConnections << QObject::connect(
+        settings.get(),
+        &DecorationSettings::alwaysShowExcludeFromCaptureChanged,
+        q,
+        [this](bool alwaysShow) {
+            setButtonState(DecorationButtonType::ExcludeFromCapture, DecorationButton::State::Visible, alwaysShow || client->isExcludedFromCapture());
+        },
+        Qt::QueuedConnection);
+}
+
+void Decoration::Private::addLightweightGroup(DecorationButtonGroup *group)
+{
+    if (!lightweightGroups.contains(group)) {
+        lightweightGroups.append(group);
+    }
+    if (!buttonStatesConnected) {
+        buttonStatesConnected = true;
+        connectButtonStates();
+        connectButtonSettings();
+    }
+}
+
+void Decoration::Private::removeLightweightGroup(DecorationButtonGroup *group)
+{
+    lightweightGroups.removeOne(group);
+}
+
+void Decoration::Private::invalidateButtonIndex()
+{
+    buttonIndexDirty = true;
+}
+
+void Decoration::Private::updateButtonIndex()
+{
+    if (!buttonIndexDirty) {
+        return;
+    }
+    buttonIndexDirty = false;
+    buttonIndex.clear();
+    for (DecorationButton *button : std::as_const(buttons)) {
+        if (!button->isEnabled() || !button->isVisible()) {
+            continue;
         }
+        const QRect geometry = button->geometry().toRect();
+        if (geometry.isEmpty()) {
+            continue;
+        }
+        buttonIndex.append(ButtonHitEntry{geometry, 0, button});
+    }
+    std::stable_sort(buttonIndex.begin(), buttonIndex.end(), [](const ButtonHitEntry &a, const ButtonHitEntry &b) {
+        return a.geometry.left() < b.geometry.left();
     });
+    int maxRight = std::numeric_limits<int>::min();
+    for (ButtonHitEntry &entry : buttonIndex) {
+        maxRight = std::max(maxRight, entry.geometry.right());
+        entry.maxRight = maxRight;
+    }
+}
+
+QVarLengthArray<DecorationButton *, 4> Decoration::Private::buttonsAt(const QPoint &pos)
+{
+    updateButtonIndex();
+    QVarLengthArray<DecorationButton *, 4> ret;
+    // first entry starting right of pos, all candidates are before it
+    auto it = std::upper_bound(buttonIndex.cbegin(), buttonIndex.cend(), pos.x(), [](int x, const ButtonHitEntry &entry) {
+        return x < entry.geometry.left();
+    });
+    while (it != buttonIndex.cbegin()) {
+        --it;
+        if (it->maxRight < pos.x()) {
+            break;
+        }
+        if (it->geometry.contains(pos)) {
+            ret.append(it->button);
+        }
+    }
+    return ret;
+}
+
+void Decoration::Private::setButtonHovered(DecorationButton *button, bool hovered)
+{
+    if (hovered) {
+        hoveredButtons.append(button);
+    } else {
+        hoveredButtons.removeOne(button);
+    }
+}
+
+void Decoration::Private::setButtonPressed(DecorationButton *button, bool pressed)
+{
+    const bool tracked = pressedButtons.contains(button);
+    if (pressed && !tracked) {
+        pressedButtons.append(button);
+    } else if (!pressed && tracked) {
+        pressedButtons.removeOne(button);
+    }
 }
 
 Decoration::Decoration(QObject *parent, const QVariantList &args)
@@ -290,7 +969,12 @@ Decoration::Decoration(QObject *parent, const QVariantList &args)
 {
 }
 
-Decoration::~Decoration() = default;
+Decoration::~Decoration()
+{
+    for (DecorationRenderCache *cache : std::as_const(d->renderCaches)) {
+        cache->d->decoration = nullptr;
+    }
+}
 
 DecoratedWindow *Decoration::window() const
 {
@@ -421,6 +1105,8 @@ void Decoration::setTitleBar(const QRectF &rect)
 {
     if (d->titleBar != rect) {
         d->titleBar = rect;
+        d->invalidateSectionMap();
+        d->publishSnapshot();
         Q_EMIT titleBarChanged();
     }
 }
@@ -544,6 +1230,27 @@ QRectF Decoration::rect() const
 
 bool Decoration::event(QEvent *event)
 {
+    if (d->statistics) {
+        d->recordEvent(event->type());
+    }
+    if (d->pendingHover) {
+        switch (event->type()) {
+        case QEvent::HoverMove:
+            break;
+        case QEvent::HoverEnter:
+        case QEvent::HoverLeave:
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonDblClick:
+        case QEvent::MouseButtonRelease:
+        case QEvent::MouseMove:
+        case QEvent::Wheel:
+            // the buttons have to know where the pointer is
+            d->flushHover();
+            break;
+        default:
+            break;
+        }
+    }
     switch (event->type()) {
     case QEvent::HoverEnter:
         hoverEnterEvent(static_cast<QHoverEvent *>(event));
@@ -552,7 +1259,11 @@ bool Decoration::event(QEvent *event)
         hoverLeaveEvent(static_cast<QHoverEvent *>(event));
         return true;
     case QEvent::HoverMove:
-        hoverMoveEvent(static_cast<QHoverEvent *>(event));
+        if (d->coalesceHover) {
+            d->queueHoverMove(static_cast<QHoverEvent *>(event));
+        } else {
+            hoverMoveEvent(static_cast<QHoverEvent *>(event));
+        }
         return true;
     case QEvent::MouseButtonPress:
         mousePressEvent(static_cast<QMouseEvent *>(event));
@@ -573,48 +1284,64 @@ bool Decoration::event(QEvent *event)
 
 void Decoration::hoverEnterEvent(QHoverEvent *event)
 {
-    for (DecorationButton *button : d->buttons) {
-        QCoreApplication::instance()->sendEvent(button, event);
+    DecorationTraceSpan span(DecorationTracing::Span::HoverDispatch, this);
+    const auto flooredPos = QPoint(std::floor(event->position().x()), std::floor(event->position().y()));
+    for (DecorationButton *button : d->buttonsAt(flooredPos)) {
+        d->enterButton(button, event);
+    }
+    for (DecorationButtonGroup *group : std::as_const(d->lightweightGroups)) {
+        group->d->hover(flooredPos);
     }
-    auto flooredPos = QPoint(std::floor(event->position().x()), std::floor(event->position().y()));
     d->updateSectionUnderMouse(flooredPos);
 }
 
 void Decoration::hoverLeaveEvent(QHoverEvent *event)
 {
-    for (DecorationButton *button : d->buttons) {
-        QCoreApplication::instance()->sendEvent(button, event);
+    DecorationTraceSpan span(DecorationTracing::Span::HoverDispatch, this);
+    const auto hoveredButtons = d->hoveredButtons;
+    for (DecorationButton *button : hoveredButtons) {
+        d->leaveButton(button, event);
+    }
+    for (DecorationButtonGroup *group : std::as_const(d->lightweightGroups)) {
+        group->d->leave();
     }
     d->setSectionUnderMouse(Qt::NoSection);
 }
 
 void Decoration::hoverMoveEvent(QHoverEvent *event)
 {
-    for (DecorationButton *button : d->buttons) {
-        if (!button->isEnabled() || !button->isVisible()) {
-            continue;
+    DecorationTraceSpan span(DecorationTracing::Span::HoverDispatch, this);
+    const auto flooredPos = QPoint(std::floor(event->position().x()), std::floor(event->position().y()));
+    const auto buttonsUnderMouse = d->buttonsAt(flooredPos);
+    // sending the events changes the hovered buttons
+    const auto hoveredButtons = d->hoveredButtons;
+    for (DecorationButton *button : hoveredButtons) {
+        if (!buttonsUnderMouse.contains(button)) {
+            d->leaveButton(button, event);
         }
-        const bool hovered = button->isHovered();
-        const bool contains = button->contains(event->position());
-        if (!hovered && contains) {
-            QHoverEvent e(QEvent::HoverEnter, event->position(), event->globalPosition(), event->oldPosF(), event->modifiers());
-            QCoreApplication::instance()->sendEvent(button, &e);
-        } else if (hovered && !contains) {
-            QHoverEvent e(QEvent::HoverLeave, event->position(), event->globalPosition(), event->oldPosF(), event->modifiers());
-            QCoreApplication::instance()->sendEvent(button, &e);
-        } else if (hovered && contains) {
-            QCoreApplication::instance()->sendEvent(button, event);
+    }
+    for (DecorationButton *button : buttonsUnderMouse) {
+        if (!button->isHovered()) {
+            d->enterButton(button, event);
+        } else if (!d->directHoverDispatch) {
+            d->sendToButton(button, event);
         }
     }
-    auto flooredPos = QPoint(std::floor(event->position().x()), std::floor(event->position().y()));
+    for (DecorationButtonGroup *group : std::as_const(d->lightweightGroups)) {
+        group->d->hover(flooredPos);
+    }
     d->updateSectionUnderMouse(flooredPos);
 }
 
 void Decoration::mouseMoveEvent(QMouseEvent *event)
 {
-    for (DecorationButton *button : d->buttons) {
-        if (button->isPressed()) {
-            QCoreApplication::instance()->sendEvent(button, event);
+    if (!d->pressedButtons.isEmpty()) {
+        d->sendToButton(d->pressedButtons.first(), event);
+        return;
+    }
+    const auto flooredPos = QPoint(std::floor(event->position().x()), std::floor(event->position().y()));
+    for (DecorationButtonGroup *group : std::as_const(d->lightweightGroups)) {
+        if (group->d->move(flooredPos)) {
             return;
         }
     }
@@ -623,22 +1350,34 @@ void Decoration::mouseMoveEvent(QMouseEvent *event)
 
 void Decoration::mousePressEvent(QMouseEvent *event)
 {
-    for (DecorationButton *button : d->buttons) {
-        if (button->isHovered()) {
-            if (button->acceptedButtons().testFlag(event->button())) {
-                QCoreApplication::instance()->sendEvent(button, event);
+    if (d->hoveredButtons.isEmpty()) {
+        const auto flooredPos = QPoint(std::floor(event->position().x()), std::floor(event->position().y()));
+        for (DecorationButtonGroup *group : std::as_const(d->lightweightGroups)) {
+            if (group->d->press(flooredPos, event->button())) {
+                event->setAccepted(true);
+                return;
             }
-            event->setAccepted(true);
-            return;
         }
+        return;
+    }
+    DecorationButton *button = d->hoveredButtons.first();
+    if (button->acceptedButtons().testFlag(event->button())) {
+        d->sendToButton(button, event);
     }
+    event->setAccepted(true);
 }
 
 void Decoration::mouseReleaseEvent(QMouseEvent *event)
 {
-    for (DecorationButton *button : d->buttons) {
-        if (button->isPressed() && button->acceptedButtons().testFlag(event->button())) {
-            QCoreApplication::instance()->sendEvent(button, event);
+    for (DecorationButton *button : std::as_const(d->pressedButtons)) {
+        if (button->acceptedButtons().testFlag(event->button())) {
+            d->sendToButton(button, event);
+            return;
+        }
+    }
+    const auto flooredPos = QPoint(std::floor(event->position().x()), std::floor(event->position().y()));
+    for (DecorationButtonGroup *group : std::as_const(d->lightweightGroups)) {
+        if (group->d->release(flooredPos, event->button())) {
             return;
         }
     }
@@ -648,17 +1387,16 @@ void Decoration::mouseReleaseEvent(QMouseEvent *event)
 
 void Decoration::wheelEvent(QWheelEvent *event)
 {
-    for (DecorationButton *button : d->buttons) {
-        if (button->contains(event->position())) {
-            QCoreApplication::instance()->sendEvent(button, event);
-            event->setAccepted(true);
-        }
+    const auto flooredPos = QPoint(std::floor(event->position().x()), std::floor(event->position().y()));
+    for (DecorationButton *button : d->buttonsAt(flooredPos)) {
+        d->sendToButton(button, event);
+        event->setAccepted(true);
     }
 }
 
 void Decoration::update(const QRectF &r)
 {
-    Q_EMIT damaged(r.isNull() ? rect().toAlignedRect() : r.toAlignedRect());
+    d->addDamage(r.isNull() ? rect().toAlignedRect() : r.toAlignedRect());
 }
 
 void Decoration::update()
@@ -666,9 +1404,43 @@ void Decoration::update()
     update(QRect());
 }
 
+void Decoration::setDamageAccumulationEnabled(bool enabled)
+{
+    if (d->accumulateDamage == enabled) {
+        return;
+    }
+    d->accumulateDamage = enabled;
+    d->damageNotified = false;
+    if (!enabled && !d->damage.isEmpty()) {
+        Q_EMIT damaged(std::exchange(d->damage, QRegion()));
+    }
+}
+
+bool Decoration::isDamageAccumulationEnabled() const
+{
+    return d->accumulateDamage;
+}
+
+QRegion Decoration::takeDamage()
+{
+    d->flushHover();
+    d->damageNotified = false;
+    return std::exchange(d->damage, QRegion());
+}
+
 void Decoration::setSettings(const std::shared_ptr<DecorationSettings> &settings)
 {
+    QObject::disconnect(d->spacingConnection);
     d->settings = settings;
+    d->invalidateSectionMap();
+    if (settings) {
+        d->spacingConnection = connect(settings.get(), &DecorationSettings::spacingChanged, this, [this] {
+            d->invalidateSectionMap();
+        });
+    }
+    if (d->buttonStatesConnected) {
+        d->connectButtonSettings();
+    }
 }
 
 std::shared_ptr<DecorationSettings> Decoration::settings() const
@@ -695,37 +1467,169 @@ void Decoration::create()
 {
     d->next = createState();
     d->current = createState();
+    d->snapshotState.reset();
+    d->publishSnapshot();
+}
+
+std::shared_ptr<const DecorationSnapshot> Decoration::snapshot() const
+{
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return d->snapshot.load(std::memory_order_acquire);
+#else
+    QT_WARNING_PUSH
+    QT_WARNING_DISABLE_DEPRECATED
+    std::shared_ptr<const DecorationSnapshot> published = std::atomic_load_explicit(&d->snapshot, std::memory_order_acquire);
+    QT_WARNING_POP
+    return published;
+#endif
 }
 
 void Decoration::setState(std::function<void(DecorationState *state)> callback)
 {
     callback(d->next.get());
+    if (d->stateChangeDepth > 0) {
+        d->stateChangePending = true;
+        return;
+    }
     Q_EMIT nextStateChanged(d->next);
 }
 
+void Decoration::beginStateChanges()
+{
+    d->stateChangeDepth++;
+}
+
+void Decoration::commitStateChanges()
+{
+    Q_ASSERT(d->stateChangeDepth > 0);
+    if (--d->stateChangeDepth > 0) {
+        return;
+    }
+    if (std::exchange(d->stateChangePending, false)) {
+        Q_EMIT nextStateChanged(d->next);
+    }
+}
+
 void Decoration::apply(std::shared_ptr<DecorationState> state)
 {
     if (d->current == state) {
         return;
     }
+    DecorationTraceSpan span(DecorationTracing::Span::ApplyState, this);
 
     const auto previous = d->current;
     d->current = state;
-    update();
+    d->snapshotState.reset();
+    if (d->statistics) {
+        d->statistics->stateApplies++;
+    }
 
-    if (previous->borders() != state->borders()) {
+    // only the fields touched since both states diverged can differ
+    DecorationState::Fields changed = state->changedFields(*previous);
+    if (changed.testFlag(DecorationState::Field::Borders) && previous->borders() == state->borders()) {
+        changed.setFlag(DecorationState::Field::Borders, false);
+    }
+    if (changed.testFlag(DecorationState::Field::BorderRadius) && previous->borderRadius() == state->borderRadius()) {
+        changed.setFlag(DecorationState::Field::BorderRadius, false);
+    }
+    if (changed.testFlag(DecorationState::Field::BorderOutline) && previous->borderOutline() == state->borderOutline()) {
+        changed.setFlag(DecorationState::Field::BorderOutline, false);
+    }
+
+    if (changed.testFlag(DecorationState::Field::Borders)) {
+        d->invalidateSectionMap();
+    }
+    if (const QRegion damage = d->stateDamage(*previous, *state, changed); !damage.isEmpty()) {
+        d->addDamage(damage);
+    }
+    d->publishSnapshot();
+
+    if (changed.testFlag(DecorationState::Field::Borders)) {
         Q_EMIT bordersChanged();
     }
-    if (previous->borderRadius() != state->borderRadius()) {
+    if (changed.testFlag(DecorationState::Field::BorderRadius)) {
         Q_EMIT borderRadiusChanged();
     }
-    if (previous->borderOutline() != state->borderOutline()) {
+    if (changed.testFlag(DecorationState::Field::BorderOutline)) {
         Q_EMIT borderOutlineChanged();
     }
 
     Q_EMIT currentStateChanged(state);
 }
 
+void Decoration::setHoverCoalescingEnabled(bool enabled)
+{
+    if (d->coalesceHover == enabled) {
+        return;
+    }
+    d->coalesceHover = enabled;
+    if (!enabled) {
+        d->flushHover();
+    }
+}
+
+bool Decoration::isHoverCoalescingEnabled() const
+{
+    return d->coalesceHover;
+}
+
+void Decoration::setHoverFlushInterval(std::chrono::milliseconds interval)
+{
+    d->hoverFlushInterval = interval;
+    if (d->hoverFlushTimer) {
+        d->hoverFlushTimer->setInterval(interval);
+    }
+}
+
+std::chrono::milliseconds Decoration::hoverFlushInterval() const
+{
+    return d->hoverFlushInterval;
+}
+
+void Decoration::setDirectHoverDispatchEnabled(bool enabled)
+{
+    d->directHoverDispatch = enabled;
+}
+
+bool Decoration::isDirectHoverDispatchEnabled() const
+{
+    return d->directHoverDispatch;
+}
+
+void Decoration::flushHoverEvents()
+{
+    d->flushHover();
+}
+
+void Decoration::setStatisticsEnabled(bool enabled)
+{
+    if (enabled == isStatisticsEnabled()) {
+        return;
+    }
+    d->statistics = enabled ? std::make_unique<DecorationStatisticsData>() : nullptr;
+}
+
+bool Decoration::isStatisticsEnabled() const
+{
+    return d->statistics != nullptr;
+}
+
+DecorationStatistics Decoration::statistics() const
+{
+    DecorationStatistics statistics;
+    if (d->statistics) {
+        statistics.d = new DecorationStatisticsData(*d->statistics);
+    }
+    return statistics;
+}
+
+void Decoration::resetStatistics()
+{
+    if (d->statistics) {
+        d->statistics = std::make_unique<DecorationStatisticsData>();
+    }
+}
+
 void Decoration::popup(const Positioner &positioner, QMenu *menu)
 {
     if (auto window = dynamic_cast<DecoratedWindowPrivateV3 *>(d->client->d.get())) {
@@ -733,6 +1637,17 @@ void Decoration::popup(const Positioner &positioner, QMenu *menu)
     }
 }
 
+DecorationStateTransaction::DecorationStateTransaction(Decoration *decoration)
+    : m_decoration(decoration)
+{
+    m_decoration->beginStateChanges();
+}
+
+DecorationStateTransaction::~DecorationStateTransaction()
+{
+    m_decoration->commitStateChanges();
+}
+
 void Decoration::requestToggleExcludeFromCapture()
 {
     if (auto window = dynamic_cast<DecoratedWindowPrivateV4 *>(d->client->d.get())) {
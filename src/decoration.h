@@ -5,6 +5,7 @@
  */
 #pragma once
 
+#include "decorationdefines.h"
 #include "decorationshadow.h"
 #include <kdecoration3/kdecoration3_export.h>
 
@@ -13,6 +14,8 @@
 #include <QRectF>
 #include <QSharedDataPointer>
 
+#include <chrono>
+
 class QHoverEvent;
 class QMenu;
 class QMouseEvent;
@@ -30,32 +33,9 @@ class DecoratedWindow;
 class DecorationButton;
 class DecorationSettings;
 class DecorationStateData;
+class DecorationStatisticsData;
 class PositionerData;
 
-/**
- * \brief Decoration corner radius.
- */
-class KDECORATIONS3_EXPORT BorderRadius
-{
-public:
-    BorderRadius();
-    explicit BorderRadius(qreal radius);
-    explicit BorderRadius(qreal topLeft, qreal topRight, qreal bottomRight, qreal bottomLeft);
-
-    auto operator<=>(const BorderRadius &other) const = default;
-
-    qreal topLeft() const;
-    qreal topRight() const;
-    qreal bottomRight() const;
-    qreal bottomLeft() const;
-
-private:
-    qreal m_topLeft = 0;
-    qreal m_topRight = 0;
-    qreal m_bottomRight = 0;
-    qreal m_bottomLeft = 0;
-};
-
 /**
  * \brief Decoration border outline.
  */
@@ -85,11 +65,30 @@ private:
  *
  * The DecorationState type represents double bufferred state associated with a decoration.
  *
+ * Every modification of a DecorationState bumps its generation(), which makes it possible to key
+ * caches on the generation instead of comparing states, and to find out which fields differ
+ * between two states with changedFields().
+ *
  * \note Sub-classes of DecorationState must override the clone() function.
+ * \note Sub-classes of DecorationState should call markDirty() when they change their own properties.
  */
 class KDECORATIONS3_EXPORT DecorationState
 {
 public:
+    /**
+     * The Field type specifies the properties of a DecorationState.
+     */
+    enum class Field {
+        Borders = 0x1,
+        BorderRadius = 0x2,
+        BorderOutline = 0x4,
+        /**
+         * Properties added by sub-classes of DecorationState.
+         */
+        Custom = 0x8,
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+
     DecorationState();
     DecorationState(const DecorationState &other);
     virtual ~DecorationState();
@@ -105,10 +104,114 @@ public:
     BorderOutline borderOutline() const;
     void setBorderOutline(const BorderOutline &outline);
 
+    /**
+     * Returns the generation of this state. The generation is increased whenever the state gets
+     * modified, a copy of a state shares the generation with its source until either of them
+     * gets modified.
+     */
+    quint64 generation() const;
+
+    /**
+     * Returns the fields that have been modified in this state or in the @p other state since
+     * they diverged. Fields that have not been touched are reported as unchanged without
+     * comparing their values.
+     */
+    Fields changedFields(const DecorationState &other) const;
+
+protected:
+    /**
+     * Marks the given @p fields as modified and increases the generation of the state.
+     *
+     * Sub-classes should call this method with Field::Custom whenever they change one of
+     * their own properties.
+     */
+    void markDirty(Fields fields);
+
 private:
     QSharedDataPointer<DecorationStateData> d;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(DecorationState::Fields)
+
+/**
+ * \brief Immutable snapshot of an applied decoration state.
+ *
+ * The DecorationSnapshot captures the current state of a Decoration together with its size,
+ * title bar and scale at the time the snapshot has been published. A snapshot never changes
+ * after it has been published, so it can be read from any thread, e.g. a render thread.
+ *
+ * \sa Decoration::snapshot()
+ */
+class KDECORATIONS3_EXPORT DecorationSnapshot
+{
+public:
+    DecorationSnapshot(const std::shared_ptr<const DecorationState> &state, const QSizeF &size, const QRectF &titleBar, qreal scale);
+
+    std::shared_ptr<const DecorationState> state() const;
+    QSizeF size() const;
+    QRectF titleBar() const;
+    qreal scale() const;
+
+private:
+    std::shared_ptr<const DecorationState> m_state;
+    QSizeF m_size;
+    QRectF m_titleBar;
+    qreal m_scale;
+};
+
+/**
+ * \brief Counters of the work done by a Decoration.
+ *
+ * \sa Decoration::setStatisticsEnabled(), Decoration::statistics()
+ */
+class KDECORATIONS3_EXPORT DecorationStatistics
+{
+public:
+    DecorationStatistics();
+    DecorationStatistics(const DecorationStatistics &other);
+    ~DecorationStatistics();
+
+    DecorationStatistics &operator=(const DecorationStatistics &other);
+
+    /**
+     * Number of emitted Decoration::damaged signals.
+     */
+    quint64 damagedEmissions() const;
+    /**
+     * Sum of the areas of all repaint requests in logical pixels. Overlapping requests are counted repeatedly.
+     */
+    quint64 damagedArea() const;
+    /**
+     * Number of hover events processed by the Decoration.
+     */
+    quint64 hoverEvents() const;
+    /**
+     * Number of mouse and wheel events processed by the Decoration, including double clicks.
+     */
+    quint64 mouseEvents() const;
+    /**
+     * Number of events forwarded by the Decoration to its DecorationButtons.
+     */
+    quint64 forwardedButtonEvents() const;
+    /**
+     * Number of applied states.
+     */
+    quint64 stateApplies() const;
+    /**
+     * Number of layout passes of the DecorationButtonGroups of the Decoration.
+     */
+    quint64 layoutPasses() const;
+    /**
+     * Time in nanoseconds spent in Decoration::paint called by a DecorationRenderCache. Paints
+     * which the compositor invokes directly on the Decoration are not included.
+     */
+    qint64 renderCachePaintTime() const;
+
+private:
+    QSharedDataPointer<DecorationStatisticsData> d;
+    friend class Decoration;
+};
+
 /**
  * \brief Popup positioner.
  *
@@ -357,6 +460,25 @@ public:
      */
     std::shared_ptr<DecorationState> nextState() const;
 
+    /**
+     * Returns the most recently published snapshot of the current state, the size, the title bar
+     * and the scale of the decoration. A new snapshot is published whenever one of them changes.
+     *
+     * Unlike the other methods of the Decoration, this method can be called from any thread, for
+     * example from a render thread while the decoration keeps applying new states. Reading an
+     * acquired snapshot does not need any locking.
+     *
+     * The snapshot is published through std::atomic<std::shared_ptr>, or the equivalent atomic
+     * free functions if the standard library lacks it. Acquiring it is thread-safe, but not
+     * guaranteed to be lock-free: the standard libraries guard the reference count with a short
+     * internal lock while the pointer gets copied. In exchange the returned snapshot stays valid
+     * for as long as the caller keeps it, unlike the data of a lock-free double buffer, which
+     * could be overwritten by the next publication while the render thread still reads it.
+     *
+     * \sa apply(), currentState()
+     */
+    std::shared_ptr<const DecorationSnapshot> snapshot() const;
+
     /**
      * Notifies the framework that the decoration state has changed. When the new state is applied
      * is subject to compositor policies. For example, the compositor may re-configure the window
@@ -364,6 +486,124 @@ public:
      */
     void setState(std::function<void(DecorationState *state)> callback);
 
+    /**
+     * Starts a batch of changes to the next state. Until the matching commitStateChanges() call,
+     * setState() only modifies the next state and the nextStateChanged() signal is emitted once
+     * when the outermost batch gets committed. Batches can be nested.
+     *
+     * \sa commitStateChanges(), DecorationStateTransaction
+     */
+    void beginStateChanges();
+
+    /**
+     * Ends a batch of changes started with beginStateChanges(). If this ends the outermost batch
+     * and the next state has been changed, the nextStateChanged() signal is emitted.
+     *
+     * \sa beginStateChanges(), DecorationStateTransaction
+     */
+    void commitStateChanges();
+
+    /**
+     * \internal
+     *
+     * Enables or disables damage accumulation. If enabled, repaint requests are collected
+     * until the compositor fetches them with takeDamage() and the damaged() signal is emitted
+     * at most once between two calls to takeDamage(), i.e. once per frame.
+     *
+     * Damage accumulation is disabled by default, damaged() is emitted for every repaint
+     * request then.
+     *
+     * \sa takeDamage()
+     */
+    void setDamageAccumulationEnabled(bool enabled);
+    bool isDamageAccumulationEnabled() const;
+
+    /**
+     * \internal
+     *
+     * Returns the damage accumulated since the last call and resets it. The compositor is
+     * supposed to call this method when it starts painting a new frame.
+     *
+     * \sa setDamageAccumulationEnabled()
+     */
+    QRegion takeDamage();
+
+    /**
+     * \internal
+     *
+     * Enables or disables hover coalescing. If enabled, hover move events are not processed
+     * immediately. Only the latest position is kept and processed once, when takeDamage() gets
+     * called at the start of the next frame, when flushHoverEvents() gets called or when the
+     * hover flush interval has passed. Any other pointer event processes the pending hover
+     * position first.
+     *
+     * This is meant for pointer devices which deliver far more motion events than frames are
+     * painted. Hover coalescing is disabled by default.
+     *
+     * \sa flushHoverEvents(), setHoverFlushInterval()
+     */
+    void setHoverCoalescingEnabled(bool enabled);
+    bool isHoverCoalescingEnabled() const;
+    /**
+     * \internal
+     *
+     * Sets the time after which a coalesced hover position gets processed at the latest. The
+     * compositor is supposed to set it to the refresh interval of the output showing the window.
+     *
+     * With damage accumulation enabled, takeDamage() processes the pending position at the start
+     * of every frame and the interval only matters while no frame gets painted. Without damage
+     * accumulation nothing else processes it, so a too long interval delays hover effects.
+     *
+     * The default interval is 16 milliseconds, one frame at 60 Hz.
+     *
+     * \sa setHoverCoalescingEnabled(), setDamageAccumulationEnabled()
+     * @since 6.8
+     */
+    void setHoverFlushInterval(std::chrono::milliseconds interval);
+    std::chrono::milliseconds hoverFlushInterval() const;
+    /**
+     * \internal
+     *
+     * Enables or disables direct hover dispatch. If enabled, the Decoration updates the hovered
+     * state of its DecorationButtons directly instead of sending QHoverEvents to them. This
+     * avoids constructing events, running event filters and testing the button geometry again
+     * for every hover transition.
+     *
+     * Only enable this if none of the buttons reimplements DecorationButton::hoverEnterEvent,
+     * DecorationButton::hoverLeaveEvent or DecorationButton::hoverMoveEvent and no event filter
+     * on the buttons relies on hover events. Direct hover dispatch is disabled by default.
+     */
+    void setDirectHoverDispatchEnabled(bool enabled);
+    bool isDirectHoverDispatchEnabled() const;
+    /**
+     * \internal
+     *
+     * Processes the pending hover position, if any.
+     *
+     * \sa setHoverCoalescingEnabled()
+     */
+    void flushHoverEvents();
+
+    /**
+     * Enables collecting statistics about the work done by this Decoration, e.g. to find out which
+     * decorations take most of the frame budget. Collecting statistics is disabled by default.
+     *
+     * \sa statistics(), resetStatistics()
+     */
+    void setStatisticsEnabled(bool enabled);
+    bool isStatisticsEnabled() const;
+    /**
+     * Returns the statistics collected since they have been enabled or reset the last time.
+     * If collecting statistics is disabled, all counters are zero.
+     *
+     * \sa resetStatistics()
+     */
+    DecorationStatistics statistics() const;
+    /**
+     * Resets all counters of the statistics, e.g. at the start of a new frame.
+     */
+    void resetStatistics();
+
     /**
      * Shows the given \a menu at the position specified by the \a positioner.
      *
@@ -476,10 +716,39 @@ protected:
 
 private:
     friend class DecorationButton;
+    friend class DecorationButtonGroup;
+    friend class DecorationRenderCache;
     class Private;
     std::unique_ptr<Private> d;
 };
 
+/**
+ * \brief Scoped batch of decoration state changes.
+ *
+ * The DecorationStateTransaction calls Decoration::beginStateChanges() when it is constructed and
+ * Decoration::commitStateChanges() when it is destroyed, so that multiple changes to the next state
+ * result in a single nextStateChanged() notification.
+ *
+ * @code
+ * {
+ *     KDecoration3::DecorationStateTransaction transaction(this);
+ *     setBorders(borders);
+ *     setBorderRadius(radius);
+ *     setBorderOutline(outline);
+ * } // nextStateChanged() is emitted once here
+ * @endcode
+ */
+class KDECORATIONS3_EXPORT DecorationStateTransaction
+{
+public:
+    explicit DecorationStateTransaction(Decoration *decoration);
+    ~DecorationStateTransaction();
+
+private:
+    Q_DISABLE_COPY_MOVE(DecorationStateTransaction)
+    Decoration *m_decoration;
+};
+
 } // namespace
 
 Q_DECLARE_METATYPE(KDecoration3::Decoration *)
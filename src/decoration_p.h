@@ -5,8 +5,18 @@
  */
 #pragma once
 #include "decoration.h"
+#include "decorationbutton.h"
 
-#include <QSet>
+#include <QList>
+#include <QTimer>
+#include <QRect>
+#include <QRegion>
+#include <QVarLengthArray>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
 
 //
 //  W A R N I N G
@@ -24,10 +34,25 @@ namespace KDecoration3
 class Decoration;
 class DecorationBridge;
 class DecorationButton;
+class DecorationButtonGroup;
+class DecorationRenderCache;
 class DecoratedWindow;
 class DecorationSettings;
 class DecorationShadow;
 
+class DecorationStatisticsData : public QSharedData
+{
+public:
+    quint64 damagedEmissions = 0;
+    quint64 damagedArea = 0;
+    quint64 hoverEvents = 0;
+    quint64 mouseEvents = 0;
+    quint64 forwardedButtonEvents = 0;
+    quint64 stateApplies = 0;
+    quint64 layoutPasses = 0;
+    qint64 renderCachePaintTime = 0;
+};
+
 class Q_DECL_HIDDEN Decoration::Private
 {
 public:
@@ -39,20 +64,150 @@ public:
     void setSectionUnderMouse(Qt::WindowFrameSection section);
     void updateSectionUnderMouse(const QPoint &mousePosition);
 
+    /**
+     * Integer edges of the frame sections, precomputed whenever the size, the borders,
+     * the title bar or the spacing changes.
+     **/
+    struct SectionMap {
+        QRect titleBar;
+        int left;
+        int right;
+        int top;
+        int bottom;
+        int leftCorner;
+        int rightCorner;
+        int topCorner;
+        int bottomCorner;
+        int titleBarTop;
+        int titleBarBottom;
+        QVarLengthArray<int, 6> columns;
+        QVarLengthArray<int, 8> rows;
+    };
+    void invalidateSectionMap();
+    void updateSectionMap();
+    Qt::WindowFrameSection sectionAt(const QPoint &pos) const;
+    QRect sectionCellAt(const QPoint &pos) const;
+    SectionMap sectionMap;
+    bool sectionMapDirty = true;
+    // the cell of the section map the mouse was last seen in
+    QRect sectionCell;
+    Qt::WindowFrameSection sectionCellSection = Qt::NoSection;
+    QMetaObject::Connection spacingConnection;
+
     QRectF titleBar;
     QRegion blurRegion;
 
+    void addDamage(const QRegion &region);
+    QRegion stateDamage(const DecorationState &previous, const DecorationState &next, DecorationState::Fields changed) const;
+    QRegion damage;
+    bool accumulateDamage = false;
+    bool damageNotified = false;
+
     void addButton(DecorationButton *button);
+    void removeButton(DecorationButton *button);
+
+    /**
+     * Forwards changes of the DecoratedWindow and the DecorationSettings to the buttons of the
+     * affected type. The signals are connected once per Decoration when the first button gets
+     * added, instead of once per button.
+     **/
+    void connectButtonStates();
+    void connectButtonSettings();
+    template<typename Function>
+    void forEachButton(DecorationButtonType type, Function function);
+    void setButtonState(DecorationButtonType type, DecorationButton::State state, bool set);
+    bool buttonStatesConnected = false;
+    QList<QMetaObject::Connection> buttonSettingsConnections;
+
+    /**
+     * The DecorationButtonGroups with lightweight buttons, they get the pointer events
+     * which are not handled by a DecorationButton.
+     **/
+    void addLightweightGroup(DecorationButtonGroup *group);
+    void removeLightweightGroup(DecorationButtonGroup *group);
+    QList<DecorationButtonGroup *> lightweightGroups;
+
+    /**
+     * Entry of the button hit-test index. The index only contains enabled and visible
+     * buttons and is sorted by the left edge of the button geometry.
+     **/
+    struct ButtonHitEntry {
+        QRect geometry;
+        // largest right edge of this entry and all entries before it
+        int maxRight;
+        DecorationButton *button;
+    };
+    void invalidateButtonIndex();
+    void updateButtonIndex();
+    QVarLengthArray<DecorationButton *, 4> buttonsAt(const QPoint &pos);
+    void setButtonHovered(DecorationButton *button, bool hovered);
+    void setButtonPressed(DecorationButton *button, bool pressed);
 
     std::shared_ptr<DecorationSettings> settings;
     DecorationBridge *bridge;
     std::shared_ptr<DecoratedWindow> client;
     bool opaque;
     QList<DecorationButton *> buttons;
+    QList<ButtonHitEntry> buttonIndex;
+    bool buttonIndexDirty = true;
+    QList<DecorationButton *> hoveredButtons;
+    QList<DecorationButton *> pressedButtons;
     Style style = Style::Titled;
     std::shared_ptr<DecorationShadow> shadow;
     std::shared_ptr<DecorationState> next;
     std::shared_ptr<DecorationState> current;
+    int stateChangeDepth = 0;
+    bool stateChangePending = false;
+
+    QList<DecorationRenderCache *> renderCaches;
+
+    void sendToButton(DecorationButton *button, QEvent *event);
+    void recordEvent(QEvent::Type type);
+    /**
+     * Paints the decoration for a DecorationRenderCache, measuring the time if statistics are enabled.
+     **/
+    void paint(QPainter *painter, const QRectF &repaintArea);
+    std::unique_ptr<DecorationStatisticsData> statistics;
+
+    struct PendingHover {
+        QPointF position;
+        QPointF globalPosition;
+        QPointF oldPosition;
+        Qt::KeyboardModifiers modifiers;
+    };
+    void enterButton(DecorationButton *button, QHoverEvent *event);
+    void leaveButton(DecorationButton *button, QHoverEvent *event);
+    bool directHoverDispatch = false;
+
+    void queueHoverMove(QHoverEvent *event);
+    void flushHover();
+    bool coalesceHover = false;
+    /**
+     * Processes the pending hover position after one frame, 60 Hz unless the compositor knows better.
+     **/
+    std::chrono::milliseconds hoverFlushInterval{16};
+    std::unique_ptr<QTimer> hoverFlushTimer;
+    std::optional<PendingHover> pendingHover;
+
+    void publishSnapshot();
+    /**
+     * The published snapshot. Without std::atomic<std::shared_ptr>, it's only accessed through
+     * std::atomic_load_explicit and std::atomic_store_explicit.
+     **/
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<std::shared_ptr<const DecorationSnapshot>> snapshot;
+#else
+    std::shared_ptr<const DecorationSnapshot> snapshot;
+#endif
+    std::shared_ptr<DecorationSnapshot> publishedSnapshot;
+    /**
+     * The previously published snapshot, reused once no reader holds it anymore.
+     **/
+    std::shared_ptr<DecorationSnapshot> spareSnapshot;
+    /**
+     * The immutable clone of the current state, shared by all snapshots until a new state gets applied.
+     **/
+    std::shared_ptr<const DecorationState> snapshotState;
 
 private:
     Decoration *q;
@@ -9,17 +9,23 @@
 #include "decoration_p.h"
 #include "decorationbutton_p.h"
 #include "decorationsettings.h"
+#include "decorationtracing_p.h"
 
 #include <KLocalizedString>
 
 #include <QDebug>
 #include <QElapsedTimer>
 #include <QGuiApplication>
+#include <QHash>
 #include <QHoverEvent>
 #include <QStyleHints>
 #include <QTimer>
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <limits>
+#include <utility>
 
 #ifndef K_DOXYGEN
 size_t qHash(const KDecoration3::DecorationButtonType &type, size_t seed)
@@ -34,21 +40,30 @@ namespace KDecoration3
 DecorationButton::Private::Private(DecorationButtonType type, const QPointer<Decoration> &decoration, DecorationButton *parent)
     : decoration(decoration)
     , type(type)
+    , acceptedButtons(Qt::LeftButton)
     , hovered(false)
     , enabled(true)
     , checkable(false)
     , checked(false)
     , visible(true)
-    , acceptedButtons(Qt::LeftButton)
     , doubleClickEnabled(false)
     , pressAndHold(false)
     , q(parent)
     , m_pressed(Qt::NoButton)
 {
+    // a decoration creates many buttons, keep their state within a few dozen bytes
+    static_assert(QT_POINTER_SIZE != 8 || sizeof(Private) <= 104, "DecorationButton::Private grew beyond its footprint budget");
+    // the initial state is not a state change
+    transitionDepth++;
     init();
+    transitionDepth--;
+    changedStates = States();
 }
 
-DecorationButton::Private::~Private() = default;
+DecorationButton::Private::~Private()
+{
+    stopPressAndHold();
+}
 
 void DecorationButton::Private::init()
 {
@@ -66,15 +81,6 @@ void DecorationButton::Private::init()
             },
             Qt::QueuedConnection);
         QObject::connect(q, &DecorationButton::doubleClicked, decoration.data(), &Decoration::requestClose, Qt::QueuedConnection);
-        QObject::connect(
-            settings.get(),
-            &DecorationSettings::closeOnDoubleClickOnMenuChanged,
-            q,
-            [this](bool enabled) {
-                doubleClickEnabled = enabled;
-                setPressAndHold(enabled);
-            },
-            Qt::QueuedConnection);
         doubleClickEnabled = settings->isCloseOnDoubleClickOnMenu();
         setPressAndHold(settings->isCloseOnDoubleClickOnMenu());
         setAcceptedButtons(Qt::LeftButton | Qt::RightButton);
@@ -91,21 +97,16 @@ void DecorationButton::Private::init()
                 decoration->requestShowApplicationMenu(q->geometry().toRect(), 0 /* actionId */);
             },
             Qt::QueuedConnection); //&Decoration::requestShowApplicationMenu, Qt::QueuedConnection);
-        QObject::connect(c, &DecoratedWindow::hasApplicationMenuChanged, q, &DecorationButton::setVisible);
-        QObject::connect(c, &DecoratedWindow::applicationMenuActiveChanged, q, &DecorationButton::setChecked);
         break;
     case DecorationButtonType::OnAllDesktops:
         setVisible(settings->isOnAllDesktopsAvailable());
         setCheckable(true);
         setChecked(c->isOnAllDesktops());
         QObject::connect(q, &DecorationButton::clicked, decoration.data(), &Decoration::requestToggleOnAllDesktops, Qt::QueuedConnection);
-        QObject::connect(settings.get(), &DecorationSettings::onAllDesktopsAvailableChanged, q, &DecorationButton::setVisible);
-        QObject::connect(c, &DecoratedWindow::onAllDesktopsChanged, q, &DecorationButton::setChecked);
         break;
     case DecorationButtonType::Minimize:
         setEnabled(c->isMinimizeable());
         QObject::connect(q, &DecorationButton::clicked, decoration.data(), &Decoration::requestMinimize, Qt::QueuedConnection);
-        QObject::connect(c, &DecoratedWindow::minimizeableChanged, q, &DecorationButton::setEnabled);
         break;
     case DecorationButtonType::Maximize:
         setEnabled(c->isMaximizeable());
@@ -113,30 +114,24 @@ void DecorationButton::Private::init()
         setChecked(c->isMaximized());
         setAcceptedButtons(Qt::LeftButton | Qt::MiddleButton | Qt::RightButton);
         QObject::connect(q, &DecorationButton::clicked, decoration.data(), &Decoration::requestToggleMaximization, Qt::QueuedConnection);
-        QObject::connect(c, &DecoratedWindow::maximizeableChanged, q, &DecorationButton::setEnabled);
-        QObject::connect(c, &DecoratedWindow::maximizedChanged, q, &DecorationButton::setChecked);
         break;
     case DecorationButtonType::Close:
         setEnabled(c->isCloseable());
         QObject::connect(q, &DecorationButton::clicked, decoration.data(), &Decoration::requestClose, Qt::QueuedConnection);
-        QObject::connect(c, &DecoratedWindow::closeableChanged, q, &DecorationButton::setEnabled);
         break;
     case DecorationButtonType::ContextHelp:
         setVisible(c->providesContextHelp());
         QObject::connect(q, &DecorationButton::clicked, decoration.data(), &Decoration::requestContextHelp, Qt::QueuedConnection);
-        QObject::connect(c, &DecoratedWindow::providesContextHelpChanged, q, &DecorationButton::setVisible);
         break;
     case DecorationButtonType::KeepAbove:
         setCheckable(true);
         setChecked(c->isKeepAbove());
         QObject::connect(q, &DecorationButton::clicked, decoration.data(), &Decoration::requestToggleKeepAbove, Qt::QueuedConnection);
-        QObject::connect(c, &DecoratedWindow::keepAboveChanged, q, &DecorationButton::setChecked);
         break;
     case DecorationButtonType::KeepBelow:
         setCheckable(true);
         setChecked(c->isKeepBelow());
         QObject::connect(q, &DecorationButton::clicked, decoration.data(), &Decoration::requestToggleKeepBelow, Qt::QueuedConnection);
-        QObject::connect(c, &DecoratedWindow::keepBelowChanged, q, &DecorationButton::setChecked);
         break;
     case DecorationButtonType::ExcludeFromCapture:
         QObject::connect(q, &DecorationButton::clicked, decoration.data(), &Decoration::requestToggleExcludeFromCapture, Qt::QueuedConnection);
@@ -144,20 +139,6 @@ void DecorationButton::Private::init()
         setCheckable(true);
         setChecked(c->isExcludedFromCapture());
 
-        QObject::connect(
-            settings.get(),
-            &DecorationSettings::alwaysShowExcludeFromCaptureChanged,
-            q,
-            [this](bool alwaysShow) {
-                setVisible(alwaysShow || q->isChecked());
-            },
-            Qt::QueuedConnection);
-
-        QObject::connect(c, &DecoratedWindow::excludeFromCaptureChanged, q, [this](bool excluded) {
-            setChecked(excluded);
-            setVisible(decoration->settings()->isAlwaysShowExcludeFromCapture() || excluded);
-        });
-
         setVisible(settings->isAlwaysShowExcludeFromCapture() || c->isExcludedFromCapture());
         break;
     case DecorationButtonType::Shade:
@@ -165,8 +146,6 @@ void DecorationButton::Private::init()
         setCheckable(true);
         setChecked(c->isShaded());
         QObject::connect(q, &DecorationButton::clicked, decoration.data(), &Decoration::requestToggleShade, Qt::QueuedConnection);
-        QObject::connect(c, &DecoratedWindow::shadedChanged, q, &DecorationButton::setChecked);
-        QObject::connect(c, &DecoratedWindow::shadeableChanged, q, &DecorationButton::setEnabled);
         break;
     case DecorationButtonType::Spacer:
         setEnabled(false);
@@ -177,26 +156,99 @@ void DecorationButton::Private::init()
     }
 }
 
+DecorationButton::Private::StateTransition::StateTransition(Private *d)
+    : d(d)
+{
+    d->transitionDepth++;
+}
+
+DecorationButton::Private::StateTransition::~StateTransition()
+{
+    if (--d->transitionDepth == 0 && d->changedStates) {
+        d->notifyStateChanged();
+    }
+}
+
+void DecorationButton::Private::notifyStateChanged()
+{
+    const States changed = std::exchange(changedStates, States());
+    q->update();
+    if (changed & State::Hovered) {
+        if (hovered) {
+            if (decoration) {
+                decoration->requestShowToolTip(typeToString(type));
+            }
+            Q_EMIT q->pointerEntered();
+        } else {
+            if (decoration) {
+                decoration->requestHideToolTip();
+            }
+            Q_EMIT q->pointerLeft();
+        }
+    }
+    if (changed & State::Pressed) {
+        if (isPressed()) {
+            if (decoration) {
+                decoration->requestHideToolTip();
+            }
+            Q_EMIT q->pressed();
+        } else {
+            Q_EMIT q->released();
+        }
+    }
+    Q_EMIT q->stateChanged(changed);
+}
+
 void DecorationButton::Private::setHovered(bool set)
 {
     if (hovered == set) {
         return;
     }
+    StateTransition transition(this);
     hovered = set;
+    changedStates |= State::Hovered;
+    if (decoration) {
+        decoration->d->setButtonHovered(q, hovered);
+    }
     Q_EMIT q->hoveredChanged(hovered);
 }
 
+void DecorationButton::Private::enter()
+{
+    if (!enabled || !visible) {
+        return;
+    }
+    setHovered(true);
+}
+
+void DecorationButton::Private::leave()
+{
+    if (!enabled || !visible) {
+        return;
+    }
+    setHovered(false);
+}
+
 void DecorationButton::Private::setEnabled(bool set)
 {
     if (enabled == set) {
         return;
     }
+    StateTransition transition(this);
     enabled = set;
+    changedStates |= State::Enabled;
+    if (decoration) {
+        decoration->d->invalidateButtonIndex();
+    }
     Q_EMIT q->enabledChanged(enabled);
     if (!enabled) {
         setHovered(false);
         if (isPressed()) {
             m_pressed = Qt::NoButton;
+            changedStates |= State::Pressed;
+            if (decoration) {
+                decoration->d->setButtonPressed(q, false);
+            }
             Q_EMIT q->pressedChanged(false);
         }
     }
@@ -207,12 +259,21 @@ void DecorationButton::Private::setVisible(bool set)
     if (visible == set) {
         return;
     }
+    StateTransition transition(this);
     visible = set;
+    changedStates |= State::Visible;
+    if (decoration) {
+        decoration->d->invalidateButtonIndex();
+    }
     Q_EMIT q->visibilityChanged(set);
     if (!visible) {
         setHovered(false);
         if (isPressed()) {
             m_pressed = Qt::NoButton;
+            changedStates |= State::Pressed;
+            if (decoration) {
+                decoration->d->setButtonPressed(q, false);
+            }
             Q_EMIT q->pressedChanged(false);
         }
     }
@@ -223,7 +284,9 @@ void DecorationButton::Private::setChecked(bool set)
     if (!checkable || checked == set) {
         return;
     }
+    StateTransition transition(this);
     checked = set;
+    changedStates |= State::Checked;
     Q_EMIT q->checkedChanged(checked);
 }
 
@@ -241,11 +304,16 @@ void DecorationButton::Private::setCheckable(bool set)
 
 void DecorationButton::Private::setPressed(Qt::MouseButton button, bool pressed)
 {
+    StateTransition transition(this);
+    changedStates |= State::Pressed;
     if (pressed) {
         m_pressed = m_pressed | button;
     } else {
         m_pressed = m_pressed & ~button;
     }
+    if (decoration) {
+        decoration->d->setButtonPressed(q, isPressed());
+    }
     Q_EMIT q->pressedChanged(isPressed());
 }
 
@@ -258,31 +326,140 @@ void DecorationButton::Private::setAcceptedButtons(Qt::MouseButtons buttons)
     Q_EMIT q->acceptedButtonsChanged(acceptedButtons);
 }
 
-void DecorationButton::Private::startDoubleClickTimer()
+class DecorationButton::Private::TimingService : public QObject
 {
-    if (!doubleClickEnabled) {
-        return;
+public:
+    static TimingService *self();
+    static qint64 timestamp();
+
+    void startPressAndHold(DecorationButton *button, int interval);
+    void stopPressAndHold(DecorationButton *button);
+
+private:
+    explicit TimingService(QCoreApplication *app);
+    void timeout();
+    void schedule();
+
+    struct PressAndHold {
+        QPointer<DecorationButton> button;
+        qint64 deadline;
+    };
+    QList<PressAndHold> m_pressAndHolds;
+    QTimer m_timer;
+};
+
+DecorationButton::Private::TimingService::TimingService(QCoreApplication *app)
+    : QObject(app)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &TimingService::timeout);
+}
+
+DecorationButton::Private::TimingService *DecorationButton::Private::TimingService::self()
+{
+    static QPointer<TimingService> s_self;
+    if (!s_self) {
+        if (QCoreApplication *app = QCoreApplication::instance()) {
+            s_self = new TimingService(app);
+        }
     }
-    if (!m_doubleClickTimer) {
-        m_doubleClickTimer = std::make_unique<QElapsedTimer>();
+    return s_self;
+}
+
+qint64 DecorationButton::Private::TimingService::timestamp()
+{
+    static const QElapsedTimer clock = [] {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock.elapsed();
+}
+
+void DecorationButton::Private::TimingService::startPressAndHold(DecorationButton *button, int interval)
+{
+    stopPressAndHold(button);
+    m_pressAndHolds.append(PressAndHold{
+        .button = button,
+        .deadline = timestamp() + interval,
+    });
+    schedule();
+}
+
+void DecorationButton::Private::TimingService::stopPressAndHold(DecorationButton *button)
+{
+    const auto it = std::find_if(m_pressAndHolds.begin(), m_pressAndHolds.end(), [button](const PressAndHold &pressAndHold) {
+        return pressAndHold.button == button;
+    });
+    if (it != m_pressAndHolds.end()) {
+        m_pressAndHolds.erase(it);
+        schedule();
     }
-    m_doubleClickTimer->start();
 }
 
-void DecorationButton::Private::invalidateDoubleClickTimer()
+void DecorationButton::Private::TimingService::schedule()
 {
-    if (!m_doubleClickTimer) {
+    if (m_pressAndHolds.isEmpty()) {
+        m_timer.stop();
         return;
     }
-    m_doubleClickTimer->invalidate();
+    qint64 deadline = std::numeric_limits<qint64>::max();
+    for (const PressAndHold &pressAndHold : std::as_const(m_pressAndHolds)) {
+        deadline = std::min(deadline, pressAndHold.deadline);
+    }
+    m_timer.start(std::chrono::milliseconds(std::max<qint64>(0, deadline - timestamp())));
 }
 
-bool DecorationButton::Private::wasDoubleClick() const
+void DecorationButton::Private::TimingService::timeout()
+{
+    const qint64 now = timestamp();
+    QList<QPointer<DecorationButton>> expired;
+    for (auto it = m_pressAndHolds.begin(); it != m_pressAndHolds.end();) {
+        if (it->deadline <= now) {
+            expired.append(it->button);
+            it = m_pressAndHolds.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    schedule();
+    // a click may destroy any of the buttons
+    for (const QPointer<DecorationButton> &button : std::as_const(expired)) {
+        if (button) {
+            Q_EMIT button->clicked(Qt::LeftButton);
+        }
+    }
+}
+
+qint64 DecorationButton::Private::timestamp()
 {
-    if (!m_doubleClickTimer || !m_doubleClickTimer->isValid()) {
+    return TimingService::timestamp();
+}
+
+bool DecorationButton::Private::isDoubleClick(qint64 releaseTime)
+{
+    if (releaseTime < 0) {
         return false;
     }
-    return !m_doubleClickTimer->hasExpired(QGuiApplication::styleHints()->mouseDoubleClickInterval());
+    return timestamp() - releaseTime <= QGuiApplication::styleHints()->mouseDoubleClickInterval();
+}
+
+void DecorationButton::Private::startDoubleClickTimer()
+{
+    if (!doubleClickEnabled) {
+        return;
+    }
+    m_releaseTime = timestamp();
+}
+
+void DecorationButton::Private::invalidateDoubleClickTimer()
+{
+    m_releaseTime = -1;
+}
+
+bool DecorationButton::Private::wasDoubleClick() const
+{
+    return isDoubleClick(m_releaseTime);
 }
 
 void DecorationButton::Private::setPressAndHold(bool enable)
@@ -290,10 +467,10 @@ void DecorationButton::Private::setPressAndHold(bool enable)
     if (pressAndHold == enable) {
         return;
     }
-    pressAndHold = enable;
-    if (!pressAndHold) {
-        m_pressAndHoldTimer.reset();
+    if (!enable) {
+        stopPressAndHold();
     }
+    pressAndHold = enable;
 }
 
 void DecorationButton::Private::startPressAndHold()
@@ -301,24 +478,39 @@ void DecorationButton::Private::startPressAndHold()
     if (!pressAndHold) {
         return;
     }
-    if (!m_pressAndHoldTimer) {
-        m_pressAndHoldTimer.reset(new QTimer());
-        m_pressAndHoldTimer->setSingleShot(true);
-        QObject::connect(m_pressAndHoldTimer.get(), &QTimer::timeout, q, [this]() {
-            q->clicked(Qt::LeftButton);
-        });
+    if (TimingService *timing = TimingService::self()) {
+        timing->startPressAndHold(q, QGuiApplication::styleHints()->mousePressAndHoldInterval());
     }
-    m_pressAndHoldTimer->start(QGuiApplication::styleHints()->mousePressAndHoldInterval());
 }
 
 void DecorationButton::Private::stopPressAndHold()
 {
-    if (m_pressAndHoldTimer) {
-        m_pressAndHoldTimer->stop();
+    if (!pressAndHold) {
+        return;
+    }
+    if (TimingService *timing = TimingService::self()) {
+        timing->stopPressAndHold(q);
     }
 }
 
-QString DecorationButton::Private::typeToString(DecorationButtonType type)
+namespace
+{
+/**
+ * Caches the translated tooltips of the DecorationButtonTypes, so hovering buttons does not
+ * need to look them up in the catalogue. The cache is cleared once the languages change.
+ **/
+class ToolTipCache
+{
+public:
+    QString toolTip(DecorationButtonType type, bool checked);
+
+private:
+    QStringList m_languages;
+    QHash<uint, QString> m_toolTips;
+};
+}
+
+static QString translatedTypeToString(DecorationButtonType type, bool checked)
 {
     switch (type) {
     case DecorationButtonType::Menu:
@@ -326,14 +518,14 @@ QString DecorationButton::Private::typeToString(DecorationButtonType type)
     case DecorationButtonType::ApplicationMenu:
         return i18n("Application menu");
     case DecorationButtonType::OnAllDesktops:
-        if (this->q->isChecked())
+        if (checked)
             return i18n("On one desktop");
         else
             return i18n("On all desktops");
     case DecorationButtonType::Minimize:
         return i18n("Minimize");
     case DecorationButtonType::Maximize:
-        if (this->q->isChecked())
+        if (checked)
             return i18n("Restore");
         else
             return i18n("Maximize");
@@ -342,22 +534,22 @@ QString DecorationButton::Private::typeToString(DecorationButtonType type)
     case DecorationButtonType::ContextHelp:
         return i18n("Context help");
     case DecorationButtonType::Shade:
-        if (this->q->isChecked())
+        if (checked)
             return i18n("Unshade");
         else
             return i18n("Shade");
     case DecorationButtonType::KeepBelow:
-        if (this->q->isChecked())
+        if (checked)
             return i18n("Don't keep below other windows");
         else
             return i18n("Keep below other windows");
     case DecorationButtonType::KeepAbove:
-        if (this->q->isChecked())
+        if (checked)
             return i18n("Don't keep above other windows");
         else
             return i18n("Keep above other windows");
     case DecorationButtonType::ExcludeFromCapture:
-        if (this->q->isChecked())
+        if (checked)
             return i18n("The window is hidden from Screencast. Press to make it visible");
         else
             return i18n("Hide from Screencast");
@@ -366,49 +558,49 @@ QString DecorationButton::Private::typeToString(DecorationButtonType type)
     }
 }
 
+QString ToolTipCache::toolTip(DecorationButtonType type, bool checked)
+{
+    // as long as the languages don't change, both lists share their data and compare cheaply
+    const QStringList languages = KLocalizedString::languages();
+    if (languages != m_languages) {
+        m_languages = languages;
+        m_toolTips.clear();
+    }
+    const uint key = uint(type) << 1 | uint(checked);
+    auto it = m_toolTips.constFind(key);
+    if (it == m_toolTips.constEnd()) {
+        DecorationTraceSpan span(DecorationTracing::Span::ToolTipLookup, nullptr);
+        it = m_toolTips.insert(key, translatedTypeToString(type, checked));
+    }
+    return *it;
+}
+
+QString DecorationButton::Private::typeToString(DecorationButtonType type)
+{
+    return toolTip(type, q->isChecked());
+}
+
+QString DecorationButton::Private::toolTip(DecorationButtonType type, bool checked)
+{
+    static ToolTipCache cache;
+    return cache.toolTip(type, checked);
+}
+
 DecorationButton::DecorationButton(DecorationButtonType type, Decoration *decoration, QObject *parent)
     : QObject(parent)
     , d(new Private(type, decoration, this))
 {
+    DecorationTraceSpan span(DecorationTracing::Span::ButtonCreation, decoration);
     decoration->d->addButton(this);
     connect(this, &DecorationButton::geometryChanged, this, static_cast<void (DecorationButton::*)(const QRectF &)>(&DecorationButton::update));
-    auto updateSlot = static_cast<void (DecorationButton::*)()>(&DecorationButton::update);
-    connect(this, &DecorationButton::hoveredChanged, this, updateSlot);
-    connect(this, &DecorationButton::hoveredChanged, this, [this](bool hovered) {
-        if (hovered) {
-            // TODO: show tooltip if hovered and hide if not
-            const QString type = this->d->typeToString(this->type());
-            this->decoration()->requestShowToolTip(type);
-        } else {
-            this->decoration()->requestHideToolTip();
-        }
-    });
-    connect(this, &DecorationButton::pressedChanged, this, updateSlot);
-    connect(this, &DecorationButton::pressedChanged, this, [this](bool pressed) {
-        if (pressed) {
-            this->decoration()->requestHideToolTip();
-        }
-    });
-    connect(this, &DecorationButton::checkedChanged, this, updateSlot);
-    connect(this, &DecorationButton::enabledChanged, this, updateSlot);
-    connect(this, &DecorationButton::visibilityChanged, this, updateSlot);
-    connect(this, &DecorationButton::hoveredChanged, this, [this](bool hovered) {
-        if (hovered) {
-            Q_EMIT pointerEntered();
-        } else {
-            Q_EMIT pointerLeft();
-        }
-    });
-    connect(this, &DecorationButton::pressedChanged, this, [this](bool p) {
-        if (p) {
-            Q_EMIT pressed();
-        } else {
-            Q_EMIT released();
-        }
-    });
 }
 
-DecorationButton::~DecorationButton() = default;
+DecorationButton::~DecorationButton()
+{
+    if (d->decoration) {
+        d->decoration->d->removeButton(this);
+    }
+}
 
 void DecorationButton::update(const QRectF &rect)
 {
@@ -506,13 +698,17 @@ void DecorationButton::setGeometry(const QRectF &geometry)
         return;
     }
     d->geometry = geometry;
+    d->pixelGeometry = geometry.toRect();
+    if (d->decoration) {
+        d->decoration->d->invalidateButtonIndex();
+    }
     Q_EMIT geometryChanged(d->geometry);
 }
 
 bool DecorationButton::contains(const QPointF &pos) const
 {
     auto flooredPoint = QPoint(std::floor(pos.x()), std::floor(pos.y()));
-    return d->geometry.toRect().contains(flooredPoint);
+    return d->pixelGeometry.contains(flooredPoint);
 }
 
 bool DecorationButton::event(QEvent *event)
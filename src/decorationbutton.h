@@ -79,6 +79,19 @@ class KDECORATIONS3_EXPORT DecorationButton : public QObject
      **/
     Q_PROPERTY(Qt::MouseButtons acceptedButtons READ acceptedButtons WRITE setAcceptedButtons NOTIFY acceptedButtonsChanged)
 public:
+    /**
+     * The State type specifies the state properties of a DecorationButton.
+     **/
+    enum class State {
+        Hovered = 0x1,
+        Pressed = 0x2,
+        Checked = 0x4,
+        Enabled = 0x8,
+        Visible = 0x10,
+    };
+    Q_DECLARE_FLAGS(States, State)
+    Q_FLAG(States)
+
     ~DecorationButton() override;
 
     QRectF geometry() const;
@@ -153,6 +166,14 @@ Q_SIGNALS:
     void geometryChanged(const QRectF &);
     void acceptedButtonsChanged(Qt::MouseButtons);
     void visibilityChanged(bool);
+    /**
+     * Emitted once after the DecorationButton changed its state, after the more specific
+     * signals like hoveredChanged or pressedChanged. A state change caused by another one, e.g.
+     * disabling a hovered and pressed button, is reported as a single notification.
+     *
+     * @param changed The state properties which changed
+     **/
+    void stateChanged(KDecoration3::DecorationButton::States changed);
 
 protected:
     explicit DecorationButton(DecorationButtonType type, Decoration *decoration, QObject *parent = nullptr);
@@ -166,10 +187,14 @@ protected:
     virtual void wheelEvent(QWheelEvent *event);
 
 private:
+    friend class Decoration;
+    friend class DecorationButtonGroup;
     class Private;
     std::unique_ptr<Private> d;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(DecorationButton::States)
+
 } // namespace
 
 #ifndef K_DOXYGEN
@@ -9,9 +9,6 @@
 
 #include <QPointer>
 
-class QElapsedTimer;
-class QTimer;
-
 //
 //  W A R N I N G
 //  -------------
@@ -40,7 +37,28 @@ public:
         return m_pressed.testFlag(button);
     }
 
+    /**
+     * Collects the state changes of one logical transition, stateChanged gets emitted
+     * and the button repainted once the outermost StateTransition ends.
+     **/
+    class StateTransition
+    {
+    public:
+        explicit StateTransition(Private *d);
+        ~StateTransition();
+
+    private:
+        Private *d;
+    };
+    void notifyStateChanged();
+
     void setHovered(bool hovered);
+    /**
+     * Direct hover dispatch used by Decoration, the pointer is known to be inside
+     * respectively outside of the button.
+     **/
+    void enter();
+    void leave();
     void setPressed(Qt::MouseButton, bool pressed);
     void setAcceptedButtons(Qt::MouseButtons buttons);
     void setEnabled(bool enabled);
@@ -50,30 +68,56 @@ public:
     void startDoubleClickTimer();
     void invalidateDoubleClickTimer();
     bool wasDoubleClick() const;
+    /**
+     * Milliseconds on the monotonic clock shared by all buttons.
+     **/
+    static qint64 timestamp();
+    /**
+     * Whether a press now is a double click, given the timestamp of the last release or -1.
+     **/
+    static bool isDoubleClick(qint64 releaseTime);
     void setPressAndHold(bool enable);
     void startPressAndHold();
     void stopPressAndHold();
 
     QString typeToString(DecorationButtonType type);
+    /**
+     * The translated tooltip for a button of @p type, cached for all buttons.
+     **/
+    static QString toolTip(DecorationButtonType type, bool checked);
+
+    /**
+     * Shared by all buttons, provides the timestamps for double click detection and
+     * runs the press and hold timeouts of all buttons on a single timer.
+     **/
+    class TimingService;
 
     QPointer<Decoration> decoration;
-    DecorationButtonType type;
     QRectF geometry;
-    bool hovered;
-    bool enabled;
-    bool checkable;
-    bool checked;
-    bool visible;
+    /**
+     * The geometry rounded to integers, used for hit testing.
+     **/
+    QRect pixelGeometry;
+    DecorationButtonType type;
     Qt::MouseButtons acceptedButtons;
-    bool doubleClickEnabled;
-    bool pressAndHold;
+    States changedStates;
+    quint16 transitionDepth = 0;
+    bool hovered : 1;
+    bool enabled : 1;
+    bool checkable : 1;
+    bool checked : 1;
+    bool visible : 1;
+    bool doubleClickEnabled : 1;
+    bool pressAndHold : 1;
 
 private:
     void init();
     DecorationButton *q;
     Qt::MouseButtons m_pressed;
-    std::unique_ptr<QElapsedTimer> m_doubleClickTimer;
-    std::unique_ptr<QTimer> m_pressAndHoldTimer;
+    /**
+     * Timestamp of the last release in milliseconds, -1 if the next press cannot be a double click.
+     **/
+    qint64 m_releaseTime = -1;
 };
 
 }
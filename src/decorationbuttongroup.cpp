@@ -4,13 +4,19 @@
  * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
  */
 #include "decorationbuttongroup.h"
+#include "decoratedwindow.h"
 #include "decoration.h"
+#include "decoration_p.h"
+#include "decorationbutton_p.h"
 #include "decorationbuttongroup_p.h"
 #include "decorationsettings.h"
+#include "decorationtracing_p.h"
 
 #include <QDebug>
 #include <QGuiApplication>
 
+#include <utility>
+
 namespace KDecoration3
 {
 DecorationButtonGroup::Private::Private(Decoration *decoration, DecorationButtonGroup *parent)
@@ -22,6 +28,261 @@ DecorationButtonGroup::Private::Private(Decoration *decoration, DecorationButton
 
 DecorationButtonGroup::Private::~Private() = default;
 
+namespace
+{
+/**
+ * The initial state of a lightweight button, matching DecorationButton::Private::init.
+ **/
+DecorationButton::States lightweightState(DecorationButtonType type, const Decoration *decoration)
+{
+    const DecoratedWindow *c = decoration->window();
+    const DecorationSettings *settings = decoration->settings().get();
+    bool enabled = true;
+    bool visible = true;
+    bool checked = false;
+    switch (type) {
+    case DecorationButtonType::ApplicationMenu:
+        visible = c->hasApplicationMenu();
+        break;
+    case DecorationButtonType::OnAllDesktops:
+        visible = settings->isOnAllDesktopsAvailable();
+        checked = c->isOnAllDesktops();
+        break;
+    case DecorationButtonType::Minimize:
+        enabled = c->isMinimizeable();
+        break;
+    case DecorationButtonType::Maximize:
+        enabled = c->isMaximizeable();
+        checked = c->isMaximized();
+        break;
+    case DecorationButtonType::Close:
+        enabled = c->isCloseable();
+        break;
+    case DecorationButtonType::ContextHelp:
+        visible = c->providesContextHelp();
+        break;
+    case DecorationButtonType::KeepAbove:
+        checked = c->isKeepAbove();
+        break;
+    case DecorationButtonType::KeepBelow:
+        checked = c->isKeepBelow();
+        break;
+    case DecorationButtonType::ExcludeFromCapture:
+        checked = c->isExcludedFromCapture();
+        visible = settings->isAlwaysShowExcludeFromCapture() || checked;
+        break;
+    case DecorationButtonType::Shade:
+        enabled = c->isShadeable();
+        checked = c->isShaded();
+        break;
+    case DecorationButtonType::Spacer:
+        enabled = false;
+        break;
+    default:
+        break;
+    }
+    DecorationButton::States state;
+    state.setFlag(DecorationButton::State::Enabled, enabled);
+    state.setFlag(DecorationButton::State::Visible, visible);
+    state.setFlag(DecorationButton::State::Checked, checked);
+    return state;
+}
+
+Qt::MouseButtons lightweightAcceptedButtons(DecorationButtonType type)
+{
+    switch (type) {
+    case DecorationButtonType::Menu:
+        return Qt::LeftButton | Qt::RightButton;
+    case DecorationButtonType::Maximize:
+        return Qt::LeftButton | Qt::MiddleButton | Qt::RightButton;
+    default:
+        return Qt::LeftButton;
+    }
+}
+
+bool isInteractive(const DecorationButton::States state)
+{
+    return state.testFlag(DecorationButton::State::Enabled) && state.testFlag(DecorationButton::State::Visible);
+}
+}
+
+void DecorationButtonGroup::Private::setLightweightGeometry(LightweightEntry &entry, const QRectF &geometry)
+{
+    if (entry.button.geometry == geometry) {
+        return;
+    }
+    if (decoration && entry.button.state.testFlag(DecorationButton::State::Visible)) {
+        decoration->update(entry.button.geometry);
+        decoration->update(geometry);
+    }
+    entry.button.geometry = geometry;
+    entry.pixelGeometry = geometry.toRect();
+}
+
+void DecorationButtonGroup::Private::setButtonState(DecorationButtonType type, DecorationButton::State state, bool set)
+{
+    bool relayout = false;
+    for (LightweightEntry &entry : lightweightButtons) {
+        if (entry.button.type != type || entry.button.state.testFlag(state) == set) {
+            continue;
+        }
+        entry.button.state.setFlag(state, set);
+        if (!isInteractive(entry.button.state)) {
+            entry.button.state &= ~(DecorationButton::State::Hovered | DecorationButton::State::Pressed);
+            entry.pressed = Qt::NoButton;
+        }
+        if (state == DecorationButton::State::Visible) {
+            relayout = true;
+        }
+        decoration->update(entry.button.geometry);
+    }
+    if (relayout) {
+        updateLayout();
+    }
+}
+
+void DecorationButtonGroup::Private::setHovered(LightweightEntry &entry, bool hovered)
+{
+    if (entry.button.state.testFlag(DecorationButton::State::Hovered) == hovered) {
+        return;
+    }
+    entry.button.state.setFlag(DecorationButton::State::Hovered, hovered);
+    decoration->update(entry.button.geometry);
+    if (hovered) {
+        const bool checked = entry.button.state.testFlag(DecorationButton::State::Checked);
+        decoration->requestShowToolTip(DecorationButton::Private::toolTip(entry.button.type, checked));
+    } else {
+        decoration->requestHideToolTip();
+    }
+}
+
+void DecorationButtonGroup::Private::trigger(const LightweightEntry &entry, Qt::MouseButton button)
+{
+    const DecorationButtonType type = entry.button.type;
+    const QRect rect = entry.button.geometry.toRect();
+    QMetaObject::invokeMethod(
+        decoration.data(),
+        [decoration = decoration.data(), type, rect, button]() {
+            switch (type) {
+            case DecorationButtonType::Menu:
+                decoration->requestShowWindowMenu(rect);
+                break;
+            case DecorationButtonType::ApplicationMenu:
+                decoration->requestShowApplicationMenu(rect, 0 /* actionId */);
+                break;
+            case DecorationButtonType::OnAllDesktops:
+                decoration->requestToggleOnAllDesktops();
+                break;
+            case DecorationButtonType::Minimize:
+                decoration->requestMinimize();
+                break;
+            case DecorationButtonType::Maximize:
+                decoration->requestToggleMaximization(button);
+                break;
+            case DecorationButtonType::Close:
+                decoration->requestClose();
+                break;
+            case DecorationButtonType::ContextHelp:
+                decoration->requestContextHelp();
+                break;
+            case DecorationButtonType::KeepAbove:
+                decoration->requestToggleKeepAbove();
+                break;
+            case DecorationButtonType::KeepBelow:
+                decoration->requestToggleKeepBelow();
+                break;
+            case DecorationButtonType::ExcludeFromCapture:
+                decoration->requestToggleExcludeFromCapture();
+                break;
+            case DecorationButtonType::Shade:
+                decoration->requestToggleShade();
+                break;
+            default:
+                break;
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+void DecorationButtonGroup::Private::hover(const QPoint &pos)
+{
+    for (LightweightEntry &entry : lightweightButtons) {
+        if (isInteractive(entry.button.state)) {
+            setHovered(entry, entry.pixelGeometry.contains(pos));
+        }
+    }
+}
+
+void DecorationButtonGroup::Private::leave()
+{
+    for (LightweightEntry &entry : lightweightButtons) {
+        setHovered(entry, false);
+    }
+}
+
+bool DecorationButtonGroup::Private::move(const QPoint &pos)
+{
+    for (LightweightEntry &entry : lightweightButtons) {
+        if (entry.pressed != Qt::NoButton) {
+            if (!entry.pixelGeometry.contains(pos)) {
+                setHovered(entry, false);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DecorationButtonGroup::Private::press(const QPoint &pos, Qt::MouseButton button)
+{
+    for (LightweightEntry &entry : lightweightButtons) {
+        if (!entry.button.state.testFlag(DecorationButton::State::Hovered)) {
+            continue;
+        }
+        if (!isInteractive(entry.button.state) || !entry.pixelGeometry.contains(pos) || !lightweightAcceptedButtons(entry.button.type).testFlag(button)) {
+            return true;
+        }
+        entry.pressed |= button;
+        entry.button.state |= DecorationButton::State::Pressed;
+        decoration->update(entry.button.geometry);
+        decoration->requestHideToolTip();
+        if (entry.button.type == DecorationButtonType::Menu && button == Qt::LeftButton && decoration->settings()->isCloseOnDoubleClickOnMenu()) {
+            if (DecorationButton::Private::isDoubleClick(entry.releaseTime)) {
+                QMetaObject::invokeMethod(decoration.data(), &Decoration::requestClose, Qt::QueuedConnection);
+            }
+            entry.releaseTime = -1;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool DecorationButtonGroup::Private::release(const QPoint &pos, Qt::MouseButton button)
+{
+    for (LightweightEntry &entry : lightweightButtons) {
+        if (!entry.pressed.testFlag(button)) {
+            continue;
+        }
+        // like a DecorationButton with press and hold, a left click on the menu button must not
+        // open the window menu if it's closed on double click, the menu would grab the pointer
+        const bool closeOnDoubleClick = entry.button.type == DecorationButtonType::Menu && button == Qt::LeftButton
+            && decoration->settings()->isCloseOnDoubleClickOnMenu();
+        if (entry.pixelGeometry.contains(pos) && !closeOnDoubleClick) {
+            trigger(entry, button);
+        }
+        entry.pressed &= ~button;
+        if (entry.pressed == Qt::NoButton) {
+            entry.button.state &= ~DecorationButton::State::Pressed;
+            decoration->update(entry.button.geometry);
+        }
+        if (entry.button.type == DecorationButtonType::Menu && button == Qt::LeftButton) {
+            entry.releaseTime = DecorationButton::Private::timestamp();
+        }
+        return true;
+    }
+    return false;
+}
+
 void DecorationButtonGroup::Private::setGeometry(const QRectF &geo)
 {
     if (geometry == geo) {
@@ -42,19 +303,41 @@ void DecorationButtonGroup::Private::updateLayout()
         return;
     }
     s_layoutRecursion = true;
+    DecorationTraceSpan span(DecorationTracing::Span::ButtonLayout, q);
+    if (decoration && decoration->d->statistics) {
+        decoration->d->statistics->layoutPasses++;
+    }
     const QPointF &pos = geometry.topLeft();
     // first calculate new size
     qreal height = 0;
     qreal width = 0;
+    bool hasVisibleButton = false;
+    // whether width ends with the spacing after a visible button
+    bool trailingSpacing = false;
     for (auto it = buttons.constBegin(); it != buttons.constEnd(); ++it) {
         if (!(*it)->isVisible()) {
             continue;
         }
         height = qMax(height, qreal((*it)->size().height()));
         width += (*it)->size().width();
-        if (it + 1 != buttons.constEnd()) {
+        hasVisibleButton = true;
+        trailingSpacing = it + 1 != buttons.constEnd();
+        if (trailingSpacing) {
+            width += spacing;
+        }
+    }
+    // lightweight buttons only add the spacing between visible buttons
+    for (const LightweightEntry &entry : std::as_const(lightweightButtons)) {
+        if (!entry.button.state.testFlag(DecorationButton::State::Visible)) {
+            continue;
+        }
+        if (hasVisibleButton && !trailingSpacing) {
             width += spacing;
         }
+        height = qMax(height, entry.button.geometry.height());
+        width += entry.button.geometry.width();
+        hasVisibleButton = true;
+        trailingSpacing = false;
     }
     setGeometry(QRectF(pos, QSizeF(width, height)));
 
@@ -64,7 +347,7 @@ void DecorationButtonGroup::Private::updateLayout()
     qreal leftPosition = pos.x();
     qreal rightPosition = pos.x() + width;
 
-    if (layoutDirection == Qt::LeftToRight)
+    if (layoutDirection == Qt::LeftToRight) {
         for (auto button : std::as_const(buttons)) {
             if (!button->isVisible()) {
                 continue;
@@ -74,7 +357,15 @@ void DecorationButtonGroup::Private::updateLayout()
             button->setGeometry(QRectF(buttonPos, size));
             leftPosition += size.width() + spacing;
         }
-    else if (layoutDirection == Qt::RightToLeft)
+        for (LightweightEntry &entry : lightweightButtons) {
+            if (!entry.button.state.testFlag(DecorationButton::State::Visible)) {
+                continue;
+            }
+            const auto size = entry.button.geometry.size();
+            setLightweightGeometry(entry, QRectF(QPointF(leftPosition, pos.y()), size));
+            leftPosition += size.width() + spacing;
+        }
+    } else if (layoutDirection == Qt::RightToLeft) {
         for (auto button : std::as_const(buttons)) {
             if (!button->isVisible()) {
                 continue;
@@ -84,7 +375,15 @@ void DecorationButtonGroup::Private::updateLayout()
             button->setGeometry(QRectF(buttonPos, size));
             rightPosition -= size.width() + spacing;
         }
-    else {
+        for (LightweightEntry &entry : lightweightButtons) {
+            if (!entry.button.state.testFlag(DecorationButton::State::Visible)) {
+                continue;
+            }
+            const auto size = entry.button.geometry.size();
+            setLightweightGeometry(entry, QRectF(QPointF(rightPosition - size.width(), pos.y()), size));
+            rightPosition -= size.width() + spacing;
+        }
+    } else {
         qCritical() << "There's an unhandled layout direction! This is likely an issue of KDecoration3 not being updated to handle it\n"
                     << "or the application having an invalid layout direction set. Either way, this is a critical bug.";
     }
@@ -126,7 +425,12 @@ DecorationButtonGroup::DecorationButtonGroup(DecorationButtonGroup::Position typ
     });
 }
 
-DecorationButtonGroup::~DecorationButtonGroup() = default;
+DecorationButtonGroup::~DecorationButtonGroup()
+{
+    if (d->decoration) {
+        d->decoration->d->removeLightweightGroup(this);
+    }
+}
 
 Decoration *DecorationButtonGroup::decoration() const
 {
@@ -144,7 +448,12 @@ bool DecorationButtonGroup::hasButton(DecorationButtonType type) const
     auto it = std::find_if(d->buttons.begin(), d->buttons.end(), [type](DecorationButton *button) {
         return button->type() == type;
     });
-    return it != d->buttons.end();
+    if (it != d->buttons.end()) {
+        return true;
+    }
+    return std::any_of(d->lightweightButtons.cbegin(), d->lightweightButtons.cend(), [type](const Private::LightweightEntry &entry) {
+        return entry.button.type == type;
+    });
 }
 
 qreal DecorationButtonGroup::spacing() const
@@ -194,6 +503,35 @@ QList<DecorationButton *> DecorationButtonGroup::buttons() const
     return d->buttons;
 }
 
+void DecorationButtonGroup::addLightweightButton(DecorationButtonType type, const QSizeF &size)
+{
+    Private::LightweightEntry entry;
+    entry.button = LightweightButton{
+        .type = type,
+        .geometry = QRectF(QPointF(0, 0), size),
+        .state = lightweightState(type, d->decoration),
+    };
+    entry.pixelGeometry = entry.button.geometry.toRect();
+    d->lightweightButtons.append(entry);
+    d->decoration->d->addLightweightGroup(this);
+    d->updateLayout();
+}
+
+QList<DecorationButtonGroup::LightweightButton> DecorationButtonGroup::lightweightButtons() const
+{
+    QList<LightweightButton> ret;
+    ret.reserve(d->lightweightButtons.size());
+    for (const Private::LightweightEntry &entry : std::as_const(d->lightweightButtons)) {
+        ret.append(entry.button);
+    }
+    return ret;
+}
+
+void DecorationButtonGroup::setLightweightButtonPainter(std::function<void(QPainter *, const LightweightButton &, const QRectF &)> painter)
+{
+    d->lightweightButtonPainter = std::move(painter);
+}
+
 void DecorationButtonGroup::removeButton(DecorationButtonType type)
 {
     bool needUpdate = false;
@@ -206,6 +544,15 @@ void DecorationButtonGroup::removeButton(DecorationButtonType type)
             it++;
         }
     }
+    for (auto it = d->lightweightButtons.begin(); it != d->lightweightButtons.end();) {
+        if (it->button.type == type) {
+            d->decoration->update(it->button.geometry);
+            it = d->lightweightButtons.erase(it);
+            needUpdate = true;
+        } else {
+            it++;
+        }
+    }
     if (needUpdate) {
         d->updateLayout();
     }
@@ -237,6 +584,15 @@ void DecorationButtonGroup::paint(QPainter *painter, const QRectF &repaintArea)
         }
         button->paint(painter, repaintArea);
     }
+    if (!d->lightweightButtonPainter) {
+        return;
+    }
+    for (const Private::LightweightEntry &entry : std::as_const(d->lightweightButtons)) {
+        if (!entry.button.state.testFlag(DecorationButton::State::Visible)) {
+            continue;
+        }
+        d->lightweightButtonPainter(painter, entry.button, repaintArea);
+    }
 }
 
 } // namespace
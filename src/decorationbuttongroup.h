@@ -23,9 +23,13 @@ class DecorationButtonGroupPrivate;
  * these groups and to update the position of each of the DecorationButtons whenever the state
  * changes in a way that they should be repositioned.
  *
- * A DecorationButtonGroup is a visual layout element not accepting input events. As a visual
- * element it provides a paint method allowing a sub class to provide custom painting for the
- * DecorationButtonGroup.
+ * A DecorationButtonGroup is a visual layout element. As a visual element it provides a paint
+ * method allowing a sub class to provide custom painting for the DecorationButtonGroup.
+ *
+ * Instead of DecorationButtons the DecorationButtonGroup can also manage lightweight buttons,
+ * see addLightweightButton(). They are meant for themes which don't need a QObject per button.
+ * The DecorationButtonGroup handles the input events the Decoration forwards to its lightweight
+ * buttons, it does not receive any input events for the DecorationButtons.
  **/
 class KDECORATIONS3_EXPORT DecorationButtonGroup : public QObject
 {
@@ -52,6 +56,24 @@ public:
         Left,
         Right,
     };
+    /**
+     * A button managed by the DecorationButtonGroup without a DecorationButton.
+     *
+     * It follows the state of the DecoratedWindow and triggers the same action when clicked as a
+     * DecorationButton of the same type. A Menu button opens the window menu when clicked. If
+     * closing the window on double click is enabled in the DecorationSettings, a left click does
+     * not open the window menu, so that the second click of a double click reaches the button.
+     * The window menu then only opens on a right click, press and hold is not supported.
+     * @since 6.8
+     **/
+    struct LightweightButton {
+        DecorationButtonType type;
+        /**
+         * The geometry in Decoration-local coordinates, positioned by the DecorationButtonGroup.
+         **/
+        QRectF geometry;
+        DecorationButton::States state;
+    };
     explicit DecorationButtonGroup(Position type,
                                    Decoration *parent,
                                    std::function<DecorationButton *(DecorationButtonType, Decoration *, QObject *)> buttonCreator);
@@ -102,12 +124,35 @@ public:
      **/
     QList<DecorationButton *> buttons() const;
 
+    /**
+     * Adds a lightweight button of @p type and @p size to the DecorationButtonGroup and
+     * triggers a re-layout. Lightweight buttons are positioned after the DecorationButtons.
+     * They get repainted through the Decoration and painted by the lightweight button painter.
+     *
+     * @see setLightweightButtonPainter
+     * @since 6.8
+     **/
+    void addLightweightButton(DecorationButtonType type, const QSizeF &size);
+    /**
+     * @returns All lightweight buttons in this DecorationButtonGroup
+     * @since 6.8
+     **/
+    QList<LightweightButton> lightweightButtons() const;
+    /**
+     * Sets the @p painter invoked from paint for each visible lightweight button. It gets passed
+     * the QPainter, the lightweight button and the area which is going to be repainted in
+     * Decoration coordinates. Without a painter lightweight buttons are not painted.
+     * @since 6.8
+     **/
+    void setLightweightButtonPainter(std::function<void(QPainter *, const LightweightButton &, const QRectF &)> painter);
+
 Q_SIGNALS:
     void spacingChanged(qreal);
     void geometryChanged(const QRectF &);
     void posChanged(const QPointF &);
 
 private:
+    friend class Decoration;
     class Private;
     std::unique_ptr<Private> d;
 };
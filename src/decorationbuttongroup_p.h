@@ -7,7 +7,8 @@
 #include "decorationbuttongroup.h"
 
 #include <QList>
-#include <QRectF>
+#include <QPointer>
+#include <QRect>
 
 //
 //  W A R N I N G
@@ -33,9 +34,33 @@ public:
     void setGeometry(const QRectF &geometry);
     void updateLayout();
 
-    Decoration *decoration;
+    struct LightweightEntry {
+        LightweightButton button;
+        /**
+         * The geometry rounded to integers, used for hit testing.
+         **/
+        QRect pixelGeometry;
+        Qt::MouseButtons pressed;
+        qint64 releaseTime = -1;
+    };
+    void setLightweightGeometry(LightweightEntry &entry, const QRectF &geometry);
+    void setButtonState(DecorationButtonType type, DecorationButton::State state, bool set);
+    void setHovered(LightweightEntry &entry, bool hovered);
+    void trigger(const LightweightEntry &entry, Qt::MouseButton button);
+    /**
+     * Pointer events forwarded by the Decoration, the positions are floored.
+     **/
+    void hover(const QPoint &pos);
+    void leave();
+    bool move(const QPoint &pos);
+    bool press(const QPoint &pos, Qt::MouseButton button);
+    bool release(const QPoint &pos, Qt::MouseButton button);
+
+    QPointer<Decoration> decoration;
     QRectF geometry;
     QList<DecorationButton *> buttons;
+    QList<LightweightEntry> lightweightButtons;
+    std::function<void(QPainter *, const LightweightButton &, const QRectF &)> lightweightButtonPainter;
     qreal spacing;
 
 private:
@@ -5,6 +5,12 @@
  */
 #pragma once
 
+#include <kdecoration3/kdecoration3_export.h>
+
+#include <QtGlobal>
+
+#include <compare>
+
 namespace KDecoration3
 {
 /**
@@ -168,4 +174,28 @@ enum class ColorRole {
     Foreground,
 };
 
+/**
+ * \brief Decoration corner radius.
+ */
+class KDECORATIONS3_EXPORT BorderRadius
+{
+public:
+    BorderRadius();
+    explicit BorderRadius(qreal radius);
+    explicit BorderRadius(qreal topLeft, qreal topRight, qreal bottomRight, qreal bottomLeft);
+
+    auto operator<=>(const BorderRadius &other) const = default;
+
+    qreal topLeft() const;
+    qreal topRight() const;
+    qreal bottomRight() const;
+    qreal bottomLeft() const;
+
+private:
+    qreal m_topLeft = 0;
+    qreal m_topRight = 0;
+    qreal m_bottomRight = 0;
+    qreal m_bottomLeft = 0;
+};
+
 }
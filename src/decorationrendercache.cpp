@@ -0,0 +1,477 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#include "decorationrendercache.h"
+#include "decoratedwindow.h"
+#include "decoration.h"
+#include "decoration_p.h"
+#include "decorationrendercache_p.h"
+
+#include <QPainter>
+#include <QPainterPath>
+
+#include <algorithm>
+#include <cmath>
+
+namespace KDecoration3
+{
+bool DecorationRenderCache::Private::Content::update(Decoration *decoration, int tileSize, qreal newScale)
+{
+    const QSizeF size = decoration->size();
+    const QSize newDeviceSize(std::ceil(size.width() * newScale), std::ceil(size.height() * newScale));
+    const quint64 newGeneration = decoration->d->current->generation();
+    const bool newActive = decoration->window()->isActive();
+
+    const bool scaleChanged = newScale != scale;
+    const bool sizeChanged = newDeviceSize != deviceSize;
+    const bool contentChanged = scaleChanged || newGeneration != generation || newActive != active;
+    scale = newScale;
+    deviceSize = newDeviceSize;
+    generation = newGeneration;
+    active = newActive;
+
+    if (mode == Mode::NineSlice) {
+        return updateNineSlice(decoration, sizeChanged, contentChanged);
+    }
+
+    if (scaleChanged || sizeChanged) {
+        tiles.clear();
+        for (int y = 0; y < deviceSize.height(); y += tileSize) {
+            for (int x = 0; x < deviceSize.width(); x += tileSize) {
+                tiles.append(Tile{
+                    .image = QImage(),
+                    .deviceRect = QRect(x, y, std::min(tileSize, deviceSize.width() - x), std::min(tileSize, deviceSize.height() - y)),
+                });
+            }
+        }
+    } else if (contentChanged) {
+        invalidate();
+    }
+    return true;
+}
+
+void DecorationRenderCache::Private::Content::markDirty(const QRegion &region)
+{
+    if (scale <= 0) {
+        return;
+    }
+    if (mode == Mode::NineSlice) {
+        // resolved with the next update, once the title bar for the new size is known
+        nineSlice.damage += region;
+        return;
+    }
+    for (Tile &tile : tiles) {
+        if (!tile.dirty && region.intersects(toLogical(tile.deviceRect).toAlignedRect())) {
+            tile.dirty = true;
+        }
+    }
+}
+
+void DecorationRenderCache::Private::Content::invalidate()
+{
+    for (Tile &tile : tiles) {
+        tile.dirty = true;
+    }
+    nineSlice.atlasDirty = true;
+    nineSlice.titleBarDirty = true;
+}
+
+qsizetype DecorationRenderCache::Private::Content::paintDirty(Decoration *decoration, qsizetype from, int maxTiles)
+{
+    if (mode == Mode::NineSlice) {
+        paintTitleBar(decoration);
+        return tiles.size();
+    }
+    qsizetype i = from;
+    for (; i < tiles.size() && maxTiles > 0; ++i) {
+        if (tiles[i].dirty) {
+            paintTile(decoration, tiles[i]);
+            --maxTiles;
+        }
+    }
+    // skip the clean tiles, so that the caller knows whether anything is left
+    while (i < tiles.size() && !tiles[i].dirty) {
+        ++i;
+    }
+    return i;
+}
+
+QRectF DecorationRenderCache::Private::Content::toLogical(const QRect &deviceRect) const
+{
+    return QRectF(deviceRect.x() / scale, deviceRect.y() / scale, deviceRect.width() / scale, deviceRect.height() / scale);
+}
+
+void DecorationRenderCache::Private::Content::paintArea(Decoration *decoration, QImage &image, const QRect &deviceRect, const QPoint &offset)
+{
+    const QRectF rect = toLogical(deviceRect);
+    QPainter painter(&image);
+    painter.translate(offset.x() / scale - rect.x(), offset.y() / scale - rect.y());
+    painter.setClipRect(rect);
+    decoration->d->paint(&painter, rect);
+}
+
+void DecorationRenderCache::Private::Content::paintTile(Decoration *decoration, Tile &tile)
+{
+    if (tile.image.isNull()) {
+        tile.image = QImage(tile.deviceRect.size(), QImage::Format_ARGB32_Premultiplied);
+        tile.image.setDevicePixelRatio(scale);
+    }
+    tile.image.fill(Qt::transparent);
+    paintArea(decoration, tile.image, tile.deviceRect, QPoint(0, 0));
+    tile.dirty = false;
+}
+
+void DecorationRenderCache::Private::Content::renderTiles(Decoration *decoration, QPainter *painter, const QRegion &region)
+{
+    painter->save();
+    painter->setClipRegion(region, Qt::IntersectClip);
+    for (Tile &tile : tiles) {
+        const QRectF rect = toLogical(tile.deviceRect);
+        if (!region.intersects(rect.toAlignedRect())) {
+            continue;
+        }
+        if (tile.dirty) {
+            paintTile(decoration, tile);
+        }
+        painter->drawImage(rect.topLeft(), tile.image);
+    }
+    painter->restore();
+}
+
+bool DecorationRenderCache::Private::Content::updateNineSlice(Decoration *decoration, bool sizeChanged, bool contentChanged)
+{
+    const QRectF titleBar = decoration->titleBar();
+    const QRect titleBarDeviceRect =
+        QRectF(titleBar.x() * scale, titleBar.y() * scale, titleBar.width() * scale, titleBar.height() * scale).toAlignedRect() & QRect(QPoint(0, 0), deviceSize);
+
+    if (contentChanged) {
+        nineSlice.atlasDirty = true;
+        nineSlice.titleBarDirty = true;
+    }
+    if (sizeChanged || titleBarDeviceRect != nineSlice.titleBarDeviceRect) {
+        nineSlice.titleBarDeviceRect = titleBarDeviceRect;
+        nineSlice.titleBarDirty = true;
+    }
+    // a resize alone keeps the corners and edges, but damage outside of the title bar can still
+    // come with it, e.g. from an animation of the borders
+    if (!nineSlice.damage.isEmpty()) {
+        const QRect logicalTitleBar = toLogical(titleBarDeviceRect).toAlignedRect();
+        if (nineSlice.damage.intersects(logicalTitleBar)) {
+            nineSlice.titleBarDirty = true;
+        }
+        if (!(nineSlice.damage - logicalTitleBar).isEmpty()) {
+            nineSlice.atlasDirty = true;
+        }
+    }
+    nineSlice.damage = QRegion();
+
+    if (nineSlice.atlasDirty) {
+        // only atlases painted for a new state can be shared, damage might be specific to this decoration
+        paintAtlas(decoration, contentChanged);
+    }
+    if (nineSlice.atlasDirty || !nineSlice.atlas) {
+        return false;
+    }
+    const QMargins &corners = nineSlice.atlas->corners;
+    return deviceSize.width() > corners.left() + corners.right() && deviceSize.height() > corners.top() + corners.bottom();
+}
+
+void DecorationRenderCache::Private::Content::paintAtlas(Decoration *decoration, bool share)
+{
+    const auto state = decoration->d->current;
+    const QMarginsF borders = state->borders();
+    const BorderRadius radius = state->borderRadius();
+    const QMargins corners(std::ceil(std::max({borders.left(), radius.topLeft(), radius.bottomLeft()}) * scale),
+                           std::ceil(std::max({borders.top(), radius.topLeft(), radius.topRight()}) * scale),
+                           std::ceil(std::max({borders.right(), radius.topRight(), radius.bottomRight()}) * scale),
+                           std::ceil(std::max({borders.bottom(), radius.bottomLeft(), radius.bottomRight()}) * scale));
+    if (deviceSize.width() <= corners.left() + corners.right() || deviceSize.height() <= corners.top() + corners.bottom()) {
+        // too small to contain an edge, try again with the next size
+        nineSlice.atlas.reset();
+        return;
+    }
+
+    AtlasKey key;
+    if (!sharingKey.isEmpty()) {
+        key = AtlasKey{
+            .className = QString::fromLatin1(decoration->metaObject()->className()),
+            .sharingKey = sharingKey,
+            .borders = borders,
+            .radius = radius,
+            .outline = state->borderOutline(),
+            .scale = scale,
+            .active = active,
+        };
+        if (share) {
+            if (auto atlas = sharedAtlases().value(key).lock()) {
+                nineSlice.atlas = atlas;
+                nineSlice.atlasDirty = false;
+                return;
+            }
+        }
+    }
+
+    QImage image(corners.left() + 1 + corners.right(), corners.top() + 1 + corners.bottom(), QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(scale);
+    image.fill(Qt::transparent);
+
+    const int sourceX[] = {0, corners.left(), deviceSize.width() - corners.right()};
+    const int sourceY[] = {0, corners.top(), deviceSize.height() - corners.bottom()};
+    const int atlasX[] = {0, corners.left(), corners.left() + 1};
+    const int atlasY[] = {0, corners.top(), corners.top() + 1};
+    const int widths[] = {corners.left(), 1, corners.right()};
+    const int heights[] = {corners.top(), 1, corners.bottom()};
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            if ((row == 1 && column == 1) || widths[column] == 0 || heights[row] == 0) {
+                continue;
+            }
+            paintArea(decoration, image, QRect(sourceX[column], sourceY[row], widths[column], heights[row]), QPoint(atlasX[column], atlasY[row]));
+        }
+    }
+
+    auto atlas = std::make_shared<const Atlas>(Atlas{image, corners});
+    // an atlas repainted because of damage isn't necessarily what the other decorations look like
+    if (share && !sharingKey.isEmpty()) {
+        auto &atlases = sharedAtlases();
+        for (auto it = atlases.begin(); it != atlases.end();) {
+            if (it->expired()) {
+                it = atlases.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        atlases.insert(key, atlas);
+    }
+    nineSlice.atlas = atlas;
+    nineSlice.atlasDirty = false;
+}
+
+void DecorationRenderCache::Private::Content::paintTitleBar(Decoration *decoration)
+{
+    if (!nineSlice.titleBarDirty) {
+        return;
+    }
+    const QRect &titleBarRect = nineSlice.titleBarDeviceRect;
+    if (titleBarRect.isEmpty()) {
+        nineSlice.titleBar = QImage();
+    } else {
+        if (nineSlice.titleBar.size() != titleBarRect.size()) {
+            nineSlice.titleBar = QImage(titleBarRect.size(), QImage::Format_ARGB32_Premultiplied);
+            nineSlice.titleBar.setDevicePixelRatio(scale);
+        }
+        nineSlice.titleBar.fill(Qt::transparent);
+        paintArea(decoration, nineSlice.titleBar, titleBarRect, QPoint(0, 0));
+    }
+    nineSlice.titleBarDirty = false;
+}
+
+void DecorationRenderCache::Private::Content::renderNineSlice(Decoration *decoration, QPainter *painter, const QRegion &region)
+{
+    paintTitleBar(decoration);
+
+    const QImage &atlas = nineSlice.atlas->image;
+    const QMargins &corners = nineSlice.atlas->corners;
+    const int targetX[] = {0, corners.left(), deviceSize.width() - corners.right()};
+    const int targetY[] = {0, corners.top(), deviceSize.height() - corners.bottom()};
+    const int targetWidths[] = {corners.left(), deviceSize.width() - corners.left() - corners.right(), corners.right()};
+    const int targetHeights[] = {corners.top(), deviceSize.height() - corners.top() - corners.bottom(), corners.bottom()};
+    const int atlasX[] = {0, corners.left(), corners.left() + 1};
+    const int atlasY[] = {0, corners.top(), corners.top() + 1};
+    const int atlasWidths[] = {corners.left(), 1, corners.right()};
+    const int atlasHeights[] = {corners.top(), 1, corners.bottom()};
+
+    // the title bar covers the parts of the atlas which depend on the size
+    QPainterPath clip;
+    clip.addRegion(region);
+    if (!nineSlice.titleBar.isNull()) {
+        QPainterPath titleBar;
+        titleBar.addRect(toLogical(nineSlice.titleBarDeviceRect));
+        clip = clip.subtracted(titleBar);
+    }
+
+    painter->save();
+    painter->setClipPath(clip, Qt::IntersectClip);
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            if ((row == 1 && column == 1) || targetWidths[column] == 0 || targetHeights[row] == 0) {
+                continue;
+            }
+            const QRectF target = toLogical(QRect(targetX[column], targetY[row], targetWidths[column], targetHeights[row]));
+            if (!region.intersects(target.toAlignedRect())) {
+                continue;
+            }
+            painter->drawImage(target, atlas, QRectF(atlasX[column], atlasY[row], atlasWidths[column], atlasHeights[row]));
+        }
+    }
+    painter->restore();
+
+    if (!nineSlice.titleBar.isNull()) {
+        const QRectF target = toLogical(nineSlice.titleBarDeviceRect);
+        if (region.intersects(target.toAlignedRect())) {
+            painter->save();
+            painter->setClipRegion(region, Qt::IntersectClip);
+            painter->drawImage(target.topLeft(), nineSlice.titleBar);
+            painter->restore();
+        }
+    }
+}
+
+QHash<DecorationRenderCache::Private::AtlasKey, std::weak_ptr<const DecorationRenderCache::Private::Atlas>> &DecorationRenderCache::Private::sharedAtlases()
+{
+    static QHash<AtlasKey, std::weak_ptr<const Atlas>> atlases;
+    return atlases;
+}
+
+DecorationRenderCache::Private::Private(Decoration *decoration, int tileSize)
+    : decoration(decoration)
+    , tileSize(std::max(tileSize, 1))
+{
+}
+
+void DecorationRenderCache::Private::markDirty(const QRegion &region)
+{
+    content.markDirty(region);
+    if (prerendered) {
+        prerendered->markDirty(region);
+    }
+}
+
+void DecorationRenderCache::Private::schedulePrerender()
+{
+    if (prerenderScheduled) {
+        return;
+    }
+    prerenderScheduled = true;
+    // painting the decoration is only possible on its thread, this doesn't offload the work, it
+    // only defers it so that it doesn't delay the code changing the scale
+    QMetaObject::invokeMethod(
+        &context,
+        [this]() {
+            prerender();
+        },
+        Qt::QueuedConnection);
+}
+
+void DecorationRenderCache::Private::prerender()
+{
+    prerenderScheduled = false;
+    if (!decoration) {
+        return;
+    }
+    const qreal nextScale = decoration->window()->nextScale();
+    if (nextScale <= 0 || nextScale == content.scale) {
+        prerendered.reset();
+        return;
+    }
+    if (!prerendered || prerendered->scale != nextScale) {
+        prerendered = Content{.mode = mode, .sharingKey = sharingKey};
+        prerenderProgress = 0;
+    }
+    if (!prerendered->update(decoration, tileSize, nextScale)) {
+        return;
+    }
+    // one tile per event loop iteration, so that input and frames aren't blocked while the whole
+    // decoration gets painted, tiles which are damaged behind the progress wait for the render
+    prerenderProgress = prerendered->paintDirty(decoration, prerenderProgress, 1);
+    if (prerenderProgress < prerendered->tiles.size()) {
+        schedulePrerender();
+    }
+}
+
+DecorationRenderCache::DecorationRenderCache(Decoration *decoration, int tileSize)
+    : d(new Private(decoration, tileSize))
+{
+    decoration->d->renderCaches.append(this);
+    QObject::connect(decoration->window(), &DecoratedWindow::nextScaleChanged, &d->context, [this]() {
+        d->schedulePrerender();
+    });
+}
+
+DecorationRenderCache::~DecorationRenderCache()
+{
+    if (d->decoration) {
+        d->decoration->d->renderCaches.removeOne(this);
+    }
+}
+
+Decoration *DecorationRenderCache::decoration() const
+{
+    return d->decoration;
+}
+
+int DecorationRenderCache::tileSize() const
+{
+    return d->tileSize;
+}
+
+void DecorationRenderCache::setMode(Mode mode)
+{
+    if (d->mode == mode) {
+        return;
+    }
+    d->mode = mode;
+    d->content = Private::Content{.mode = mode, .sharingKey = d->sharingKey};
+    d->prerendered.reset();
+}
+
+DecorationRenderCache::Mode DecorationRenderCache::mode() const
+{
+    return d->mode;
+}
+
+void DecorationRenderCache::setSharingKey(const QString &key)
+{
+    if (d->sharingKey == key) {
+        return;
+    }
+    d->sharingKey = key;
+    d->content = Private::Content{.mode = d->mode, .sharingKey = key};
+    d->prerendered.reset();
+}
+
+QString DecorationRenderCache::sharingKey() const
+{
+    return d->sharingKey;
+}
+
+void DecorationRenderCache::render(QPainter *painter, const QRegion &region, qreal scale)
+{
+    if (!d->decoration || scale <= 0) {
+        return;
+    }
+    if (d->prerendered && d->prerendered->scale == scale) {
+        d->content = std::move(*d->prerendered);
+        d->prerendered.reset();
+    }
+    if (!d->content.update(d->decoration, d->tileSize, scale)) {
+        painter->save();
+        painter->setClipRegion(region, Qt::IntersectClip);
+        d->decoration->d->paint(painter, region.boundingRect());
+        painter->restore();
+        return;
+    }
+
+    if (d->mode == Mode::NineSlice) {
+        d->content.renderNineSlice(d->decoration, painter, region);
+    } else {
+        d->content.renderTiles(d->decoration, painter, region);
+    }
+}
+
+bool DecorationRenderCache::isPrerendered(qreal scale) const
+{
+    return d->prerendered && d->prerendered->scale == scale && !d->prerenderScheduled;
+}
+
+void DecorationRenderCache::invalidate()
+{
+    d->content.invalidate();
+    if (d->prerendered) {
+        d->prerendered->invalidate();
+    }
+}
+
+}
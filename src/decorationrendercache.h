@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#pragma once
+
+#include <kdecoration3/kdecoration3_export.h>
+
+#include <QRegion>
+
+#include <memory>
+
+class QPainter;
+
+namespace KDecoration3
+{
+class Decoration;
+
+/**
+ * @brief Caches the rendered Decoration in tiles.
+ *
+ * The DecorationRenderCache keeps the output of Decoration::paint rasterized in fixed-size
+ * QImage tiles. When the cache gets rendered only the tiles which got damaged since the last
+ * render are repainted by the Decoration, all other tiles are reused. That way a backend can
+ * reuse unchanged parts of the Decoration across frames instead of painting the whole Decoration
+ * for every damage.
+ *
+ * The tiles are keyed on the current state of the Decoration, the active state of the
+ * DecoratedWindow and the scale. If any of them changes, all tiles are repainted with the next
+ * render. A change of the size or of the scale discards the tiles.
+ *
+ * In the NineSlice mode the corners of the Decoration and a strip of one device pixel of
+ * every edge are painted once into an atlas, which is composed for arbitrary sizes. Only the
+ * title bar gets repainted when the size changes. This avoids repainting the whole Decoration
+ * for every frame of an interactive resize, but requires that the corners don't depend on the
+ * size of the Decoration and that the edges are uniform. Damage reported together with a size
+ * change only repaints the title bar. Decorations which look the same can share the corners
+ * and edges, see setSharingKey().
+ *
+ * When the DecoratedWindow announces a new scale through DecoratedWindow::nextScale, the
+ * content for that scale is painted ahead of time from the event loop. This doesn't move the
+ * painting to another thread, it still happens on the thread of the Decoration, it is only
+ * deferred and spread over several event loop iterations, one tile per iteration. Once the cache
+ * gets rendered at the new scale the prerendered content replaces the current one, tiles which
+ * haven't been prerendered yet are painted then, so switching the scale doesn't require
+ * repainting the whole Decoration.
+ *
+ * The DecorationRenderCache must be used from the thread the Decoration lives in.
+ **/
+class KDECORATIONS3_EXPORT DecorationRenderCache
+{
+public:
+    enum class Mode {
+        /**
+         * The whole Decoration is cached in tiles.
+         **/
+        Tiles,
+        /**
+         * The corners and edges are cached in an atlas, the title bar is cached separately.
+         **/
+        NineSlice,
+    };
+
+    /**
+     * Creates a render cache for @p decoration using tiles of @p tileSize device pixels.
+     **/
+    explicit DecorationRenderCache(Decoration *decoration, int tileSize = 128);
+    ~DecorationRenderCache();
+
+    /**
+     * The Decoration rendered by this cache. Becomes @c nullptr once the Decoration is destroyed.
+     **/
+    Decoration *decoration() const;
+    /**
+     * The size of the tiles in device pixels.
+     **/
+    int tileSize() const;
+
+    /**
+     * Sets the @p mode used to cache the Decoration. The default is Mode::Tiles.
+     * Changing the mode discards all cached content.
+     **/
+    void setMode(Mode mode);
+    Mode mode() const;
+
+    /**
+     * Sets the @p key under which the corners and edges cached in the NineSlice mode are shared
+     * with other decorations. Decorations of the same type with equal borders, border radius,
+     * border outline, scale and active state and the same sharing key paint their corners and
+     * edges only once, and share the memory for them.
+     *
+     * The key has to cover everything else the corners and edges depend on, e.g. the color
+     * scheme of the window or properties added by sub-classes of DecorationState.
+     * By default the key is empty, which disables sharing.
+     **/
+    void setSharingKey(const QString &key);
+    QString sharingKey() const;
+
+    /**
+     * Renders the @p region of the Decoration at the given @p scale into @p painter.
+     * The @p region is in logical coordinates of the Decoration.
+     *
+     * Tiles intersecting @p region which got damaged since they have been painted the last
+     * time are repainted through Decoration::paint before they are drawn.
+     **/
+    void render(QPainter *painter, const QRegion &region, qreal scale);
+    /**
+     * Marks all tiles as damaged, they get repainted with the next render.
+     **/
+    void invalidate();
+    /**
+     * Returns @c true if the content for @p scale has been painted ahead of time completely.
+     **/
+    bool isPrerendered(qreal scale) const;
+
+private:
+    friend class Decoration;
+    class Private;
+    std::unique_ptr<Private> d;
+
+    Q_DISABLE_COPY_MOVE(DecorationRenderCache)
+};
+
+}
@@ -0,0 +1,175 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#pragma once
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the KDecoration3 API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "decoration.h"
+#include "decorationrendercache.h"
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMargins>
+#include <QObject>
+#include <QRect>
+
+#include <memory>
+#include <optional>
+
+namespace KDecoration3
+{
+class Q_DECL_HIDDEN DecorationRenderCache::Private
+{
+public:
+    struct Tile {
+        QImage image;
+        QRect deviceRect;
+        bool dirty = true;
+    };
+
+    struct Atlas {
+        /**
+         * Corners and one pixel wide edges, the edges are between the corners.
+         **/
+        QImage image;
+        /**
+         * Size of the corners in device pixels.
+         **/
+        QMargins corners;
+    };
+
+    /**
+     * Identifies atlases which can be shared between decorations.
+     **/
+    struct AtlasKey {
+        QString className;
+        QString sharingKey;
+        QMarginsF borders;
+        BorderRadius radius;
+        BorderOutline outline;
+        qreal scale = 0;
+        bool active = false;
+
+        /**
+         * Compares the borders exactly like qHash does, QMarginsF compares fuzzily.
+         **/
+        bool operator==(const AtlasKey &other) const
+        {
+            return className == other.className && sharingKey == other.sharingKey && borders.left() == other.borders.left()
+                && borders.top() == other.borders.top() && borders.right() == other.borders.right() && borders.bottom() == other.borders.bottom()
+                && radius == other.radius && outline == other.outline && scale == other.scale && active == other.active;
+        }
+
+        friend size_t qHash(const AtlasKey &key, size_t seed = 0)
+        {
+            return qHashMulti(seed,
+                              key.className,
+                              key.sharingKey,
+                              key.borders.left(),
+                              key.borders.top(),
+                              key.borders.right(),
+                              key.borders.bottom(),
+                              key.radius.topLeft(),
+                              key.radius.topRight(),
+                              key.radius.bottomRight(),
+                              key.radius.bottomLeft(),
+                              key.outline.thickness(),
+                              key.outline.color().rgba(),
+                              key.scale,
+                              key.active);
+        }
+    };
+
+    /**
+     * Atlases currently in use by any DecorationRenderCache with a sharing key.
+     **/
+    static QHash<AtlasKey, std::weak_ptr<const Atlas>> &sharedAtlases();
+
+    struct NineSlice {
+        std::shared_ptr<const Atlas> atlas;
+        QImage titleBar;
+        QRect titleBarDeviceRect;
+        QRegion damage;
+        bool atlasDirty = true;
+        bool titleBarDirty = true;
+    };
+
+    /**
+     * The cached content for one scale.
+     **/
+    struct Content {
+        /**
+         * Adjusts the cached content to the current state, size and @p scale of the decoration.
+         * Returns @c false if the cached content can't be used for the current size.
+         **/
+        bool update(Decoration *decoration, int tileSize, qreal scale);
+        void markDirty(const QRegion &region);
+        void invalidate();
+        /**
+         * Paints up to @p maxTiles dirty tiles, starting at the tile with index @p from.
+         * Returns the index of the next dirty tile, or the number of tiles if none is left.
+         * In the NineSlice mode the title bar is painted at once.
+         **/
+        qsizetype paintDirty(Decoration *decoration, qsizetype from, int maxTiles);
+        QRectF toLogical(const QRect &deviceRect) const;
+        void paintArea(Decoration *decoration, QImage &image, const QRect &deviceRect, const QPoint &offset);
+
+        void paintTile(Decoration *decoration, Tile &tile);
+        void renderTiles(Decoration *decoration, QPainter *painter, const QRegion &region);
+
+        bool updateNineSlice(Decoration *decoration, bool sizeChanged, bool contentChanged);
+        void paintAtlas(Decoration *decoration, bool share);
+        void paintTitleBar(Decoration *decoration);
+        void renderNineSlice(Decoration *decoration, QPainter *painter, const QRegion &region);
+
+        Mode mode = Mode::Tiles;
+        QString sharingKey;
+        quint64 generation = 0;
+        bool active = false;
+        qreal scale = 0;
+        QSize deviceSize;
+        QList<Tile> tiles;
+        NineSlice nineSlice;
+    };
+
+    explicit Private(Decoration *decoration, int tileSize);
+
+    void markDirty(const QRegion &region);
+    void schedulePrerender();
+    /**
+     * Paints the content for the next scale of the window ahead of time, one tile per call.
+     * Reschedules itself until all tiles are painted.
+     **/
+    void prerender();
+
+    Decoration *decoration;
+    int tileSize;
+    Mode mode = Mode::Tiles;
+    QString sharingKey;
+    Content content;
+    std::optional<Content> prerendered;
+    /**
+     * Index of the next tile to prerender.
+     **/
+    qsizetype prerenderProgress = 0;
+    bool prerenderScheduled = false;
+    /**
+     * Context of the connections and the queued prerendering.
+     **/
+    QObject context;
+};
+
+}
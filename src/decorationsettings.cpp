@@ -15,6 +15,10 @@ DecorationSettings::DecorationSettings(DecorationBridge *bridge, QObject *parent
     : QObject(parent)
     , d(bridge->settings(this))
 {
+    // connected first, so that everything else sees the new font
+    connect(this, &DecorationSettings::fontChanged, this, [this] {
+        d->invalidateFontCache();
+    });
     auto updateUnits = [this] {
         int gridUnit = QFontMetrics(font()).boundingRect(QLatin1Char('M')).height();
         ;
@@ -69,12 +73,17 @@ BorderSize DecorationSettings::borderSize() const
 
 QFont DecorationSettings::font() const
 {
-    return d->font();
+    return d->cachedFont();
 }
 
 QFontMetricsF DecorationSettings::fontMetrics() const
 {
-    return d->fontMetrics();
+    return d->cachedFontMetrics();
+}
+
+QFontMetricsF DecorationSettings::fontMetrics(qreal scale) const
+{
+    return d->cachedFontMetrics(scale);
 }
 
 int DecorationSettings::gridUnit() const
@@ -106,6 +106,13 @@ public:
      * @see font
      **/
     QFontMetricsF fontMetrics() const;
+    /**
+     * The fontMetrics for the recommended font rendered at @p scale, in device pixels.
+     * The font and all metrics are cached until the font changes.
+     * @see font
+     * @since 6.8
+     **/
+    QFontMetricsF fontMetrics(qreal scale) const;
 
     int gridUnit() const;
     int smallSpacing() const;
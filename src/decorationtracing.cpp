@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#include "decorationtracing.h"
+#include "decorationtracing_p.h"
+
+namespace KDecoration3
+{
+std::atomic<DecorationTracing::Callback> g_tracingCallback = nullptr;
+
+void DecorationTracing::setCallback(Callback callback)
+{
+    g_tracingCallback.store(callback, std::memory_order_relaxed);
+}
+
+DecorationTracing::Callback DecorationTracing::callback()
+{
+    return g_tracingCallback.load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#pragma once
+
+#include <kdecoration3/kdecoration3_export.h>
+
+class QObject;
+
+namespace KDecoration3
+{
+
+/**
+ * @brief Hooks to trace the work done by decorations.
+ *
+ * A compositor can register a process wide callback which gets invoked at the begin and the end
+ * of the hot paths of all decorations, e.g. to show the work in its own trace viewer next to its
+ * frame timeline. As long as no callback is registered, tracing costs one atomic load per span.
+ *
+ * The callback gets invoked on the thread doing the work, usually the main thread. Spans of the
+ * same thread are properly nested.
+ **/
+class KDECORATIONS3_EXPORT DecorationTracing
+{
+public:
+    enum class Span {
+        /**
+         * Decoration::paint called by the library, e.g. from a DecorationRenderCache.
+         **/
+        Paint,
+        /**
+         * Decoration::apply.
+         **/
+        ApplyState,
+        /**
+         * A layout pass of a DecorationButtonGroup.
+         **/
+        ButtonLayout,
+        /**
+         * Dispatching a hover event from a Decoration to its DecorationButtons.
+         **/
+        HoverDispatch,
+        /**
+         * Construction of a DecorationButton.
+         **/
+        ButtonCreation,
+        /**
+         * Looking up the translated tooltip of a button type, only done if it isn't cached yet.
+         **/
+        ToolTipLookup,
+    };
+
+    enum class Phase {
+        Begin,
+        End,
+    };
+
+    /**
+     * The @p object is the Decoration, DecorationButtonGroup or DecorationButton doing the work.
+     * For Span::ButtonCreation it is the Decoration the button gets created for. For
+     * Span::ToolTipLookup it is @c nullptr, the tooltips are shared by all decorations.
+     **/
+    using Callback = void (*)(Span span, Phase phase, const QObject *object);
+
+    /**
+     * Registers the process wide @p callback, replacing the previous one. Pass @c nullptr to
+     * disable tracing.
+     **/
+    static void setCallback(Callback callback);
+    static Callback callback();
+};
+
+}
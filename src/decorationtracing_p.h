@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#pragma once
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the KDecoration3 API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "decorationtracing.h"
+
+#include <QtGlobal>
+
+#include <atomic>
+
+namespace KDecoration3
+{
+extern std::atomic<DecorationTracing::Callback> g_tracingCallback;
+
+/**
+ * Reports a span to the tracing callback for the lifetime of the object.
+ **/
+class Q_DECL_HIDDEN DecorationTraceSpan
+{
+public:
+    DecorationTraceSpan(DecorationTracing::Span span, const QObject *object)
+        : m_callback(g_tracingCallback.load(std::memory_order_relaxed))
+        , m_span(span)
+        , m_object(object)
+    {
+        if (m_callback) [[unlikely]] {
+            m_callback(m_span, DecorationTracing::Phase::Begin, m_object);
+        }
+    }
+    ~DecorationTraceSpan()
+    {
+        if (m_callback) [[unlikely]] {
+            m_callback(m_span, DecorationTracing::Phase::End, m_object);
+        }
+    }
+
+    Q_DISABLE_COPY_MOVE(DecorationTraceSpan)
+
+private:
+    const DecorationTracing::Callback m_callback;
+    const DecorationTracing::Span m_span;
+    const QObject *const m_object;
+};
+
+}
@@ -0,0 +1,221 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#include "decorationeventrecorder.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QHoverEvent>
+#include <QIODevice>
+#include <QMouseEvent>
+#include <QWheelEvent>
+
+namespace KDecoration3
+{
+namespace
+{
+constexpr quint32 s_magic = 0x4b444556; // KDEV
+constexpr quint32 s_version = 1;
+
+void prepareStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream.setByteOrder(QDataStream::LittleEndian);
+}
+}
+
+class DecorationEventRecorder::Private
+{
+public:
+    explicit Private(QIODevice *device);
+
+    QDataStream stream;
+    int events = 0;
+};
+
+DecorationEventRecorder::Private::Private(QIODevice *device)
+    : stream(device)
+{
+    prepareStream(stream);
+    stream << s_magic << s_version;
+}
+
+DecorationEventRecorder::DecorationEventRecorder(QIODevice *device, QObject *parent)
+    : QObject(parent)
+    , d(new Private(device))
+{
+}
+
+DecorationEventRecorder::~DecorationEventRecorder() = default;
+
+void DecorationEventRecorder::record(QObject *target)
+{
+    target->installEventFilter(this);
+}
+
+void DecorationEventRecorder::stop(QObject *target)
+{
+    target->removeEventFilter(this);
+}
+
+int DecorationEventRecorder::recordedEvents() const
+{
+    return d->events;
+}
+
+bool DecorationEventRecorder::eventFilter(QObject *watched, QEvent *event)
+{
+    Q_UNUSED(watched)
+    QDataStream &stream = d->stream;
+    switch (event->type()) {
+    case QEvent::HoverEnter:
+    case QEvent::HoverLeave:
+    case QEvent::HoverMove: {
+        const auto hoverEvent = static_cast<QHoverEvent *>(event);
+        stream << quint8(event->type()) << quint64(hoverEvent->timestamp()) << hoverEvent->position() << hoverEvent->oldPosF()
+               << quint32(hoverEvent->modifiers());
+        break;
+    }
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove: {
+        const auto mouseEvent = static_cast<QMouseEvent *>(event);
+        stream << quint8(event->type()) << quint64(mouseEvent->timestamp()) << mouseEvent->position() << quint32(mouseEvent->button())
+               << quint32(mouseEvent->buttons()) << quint32(mouseEvent->modifiers());
+        break;
+    }
+    case QEvent::Wheel: {
+        const auto wheelEvent = static_cast<QWheelEvent *>(event);
+        stream << quint8(event->type()) << quint64(wheelEvent->timestamp()) << wheelEvent->position() << wheelEvent->pixelDelta()
+               << wheelEvent->angleDelta() << quint32(wheelEvent->buttons()) << quint32(wheelEvent->modifiers()) << wheelEvent->inverted();
+        break;
+    }
+    default:
+        return false;
+    }
+    d->events++;
+    return false;
+}
+
+class DecorationEventPlayer::Private
+{
+public:
+    explicit Private(QIODevice *device);
+
+    QDataStream stream;
+    bool valid = false;
+};
+
+DecorationEventPlayer::Private::Private(QIODevice *device)
+    : stream(device)
+{
+    prepareStream(stream);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    valid = stream.status() == QDataStream::Ok && magic == s_magic && version == s_version;
+}
+
+DecorationEventPlayer::DecorationEventPlayer(QIODevice *device)
+    : d(new Private(device))
+{
+}
+
+DecorationEventPlayer::~DecorationEventPlayer() = default;
+
+bool DecorationEventPlayer::isValid() const
+{
+    return d->valid;
+}
+
+DecorationEventPlayer::Statistics DecorationEventPlayer::play(QObject *target)
+{
+    Statistics statistics;
+    if (!d->valid) {
+        return statistics;
+    }
+    QDataStream &stream = d->stream;
+    QElapsedTimer timer;
+    timer.start();
+    while (!stream.atEnd()) {
+        quint8 type = 0;
+        quint64 timestamp = 0;
+        QPointF position;
+        quint32 modifiers = 0;
+        stream >> type >> timestamp >> position;
+        switch (QEvent::Type(type)) {
+        case QEvent::HoverEnter:
+        case QEvent::HoverLeave:
+        case QEvent::HoverMove: {
+            QPointF oldPosition;
+            stream >> oldPosition >> modifiers;
+            if (stream.status() != QDataStream::Ok) {
+                break;
+            }
+            QHoverEvent event(QEvent::Type(type), position, position, oldPosition, Qt::KeyboardModifiers(modifiers));
+            event.setTimestamp(timestamp);
+            QCoreApplication::sendEvent(target, &event);
+            break;
+        }
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonRelease:
+        case QEvent::MouseButtonDblClick:
+        case QEvent::MouseMove: {
+            quint32 button = 0;
+            quint32 buttons = 0;
+            stream >> button >> buttons >> modifiers;
+            if (stream.status() != QDataStream::Ok) {
+                break;
+            }
+            QMouseEvent event(QEvent::Type(type),
+                              position,
+                              position,
+                              Qt::MouseButton(button),
+                              Qt::MouseButtons(buttons),
+                              Qt::KeyboardModifiers(modifiers));
+            event.setTimestamp(timestamp);
+            QCoreApplication::sendEvent(target, &event);
+            break;
+        }
+        case QEvent::Wheel: {
+            QPoint pixelDelta;
+            QPoint angleDelta;
+            quint32 buttons = 0;
+            bool inverted = false;
+            stream >> pixelDelta >> angleDelta >> buttons >> modifiers >> inverted;
+            if (stream.status() != QDataStream::Ok) {
+                break;
+            }
+            QWheelEvent event(position,
+                              position,
+                              pixelDelta,
+                              angleDelta,
+                              Qt::MouseButtons(buttons),
+                              Qt::KeyboardModifiers(modifiers),
+                              Qt::NoScrollPhase,
+                              inverted);
+            event.setTimestamp(timestamp);
+            QCoreApplication::sendEvent(target, &event);
+            break;
+        }
+        default:
+            qWarning("Unknown event type %d in decoration event recording", type);
+            stream.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+        if (stream.status() != QDataStream::Ok) {
+            break;
+        }
+        statistics.events++;
+    }
+    statistics.elapsedNanoseconds = timer.nsecsElapsed();
+    return statistics;
+}
+
+}
+
+#include "moc_decorationeventrecorder.cpp"
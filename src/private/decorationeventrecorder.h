@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: 2026 KDecoration contributors
+ *
+ * SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+ */
+#pragma once
+
+#include <QObject>
+
+#include <memory>
+
+#include <kdecoration3/private/kdecoration3_private_export.h>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the KDecoration3 API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+class QIODevice;
+
+namespace KDecoration3
+{
+
+/**
+ * Records the pointer events delivered to a Decoration into a compact binary stream.
+ *
+ * Hover, mouse and wheel events are written with their timestamp, positions, buttons and
+ * modifiers. The recording can be replayed with a DecorationEventPlayer.
+ **/
+class KDECORATIONS_PRIVATE_EXPORT DecorationEventRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Creates a recorder writing to @p device, which must be open for writing.
+     **/
+    explicit DecorationEventRecorder(QIODevice *device, QObject *parent = nullptr);
+    ~DecorationEventRecorder() override;
+
+    /**
+     * Starts recording the events delivered to @p target, usually a Decoration.
+     **/
+    void record(QObject *target);
+    /**
+     * Stops recording the events delivered to @p target.
+     **/
+    void stop(QObject *target);
+    /**
+     * The number of events recorded so far.
+     **/
+    int recordedEvents() const;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    class Private;
+    const std::unique_ptr<Private> d;
+};
+
+/**
+ * Replays pointer events recorded by a DecorationEventRecorder.
+ **/
+class KDECORATIONS_PRIVATE_EXPORT DecorationEventPlayer
+{
+public:
+    struct Statistics {
+        int events = 0;
+        qint64 elapsedNanoseconds = 0;
+    };
+
+    /**
+     * Creates a player reading from @p device, which must be open for reading.
+     **/
+    explicit DecorationEventPlayer(QIODevice *device);
+    ~DecorationEventPlayer();
+
+    /**
+     * @returns @c true if the device contains a recording which can be replayed.
+     **/
+    bool isValid() const;
+    /**
+     * Sends all recorded events to @p target as fast as possible. The events keep
+     * their recorded timestamps.
+     **/
+    Statistics play(QObject *target);
+
+private:
+    class Private;
+    const std::unique_ptr<Private> d;
+};
+
+}
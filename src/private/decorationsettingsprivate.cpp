@@ -5,6 +5,10 @@
  */
 #include "decorationsettingsprivate.h"
 #include <QFontDatabase>
+#include <QMutex>
+
+#include <optional>
+#include <utility>
 
 namespace KDecoration3
 {
@@ -16,6 +20,14 @@ public:
     int gridUnit = -1;
     int smallSpacing = -1;
     int largeSpacing = -1;
+
+    // the font can be queried while painting, which might happen on another thread
+    QMutex fontMutex;
+    // incremented by invalidateFontCache(), values queried for an older generation are not cached
+    quint64 fontGeneration = 0;
+    std::optional<QFont> font;
+    std::optional<QFontMetricsF> fontMetrics;
+    QList<std::pair<qreal, QFontMetricsF>> scaledFontMetrics;
 };
 
 DecorationSettingsPrivate::Private::Private(DecorationSettings *settings)
@@ -82,6 +94,78 @@ void DecorationSettingsPrivate::setSmallSpacing(int spacing)
     d->smallSpacing = spacing;
 }
 
+QFont DecorationSettingsPrivate::cachedFont() const
+{
+    QMutexLocker locker(&d->fontMutex);
+    if (d->font) {
+        return *d->font;
+    }
+    const quint64 generation = d->fontGeneration;
+    // the implementation might call back into the DecorationSettings, don't hold the lock
+    locker.unlock();
+    const QFont font = this->font();
+    locker.relock();
+    if (generation == d->fontGeneration) {
+        d->font = font;
+    }
+    return font;
+}
+
+QFontMetricsF DecorationSettingsPrivate::cachedFontMetrics() const
+{
+    QMutexLocker locker(&d->fontMutex);
+    if (d->fontMetrics) {
+        return *d->fontMetrics;
+    }
+    const quint64 generation = d->fontGeneration;
+    locker.unlock();
+    const QFontMetricsF metrics = fontMetrics();
+    locker.relock();
+    if (generation == d->fontGeneration) {
+        d->fontMetrics = metrics;
+    }
+    return metrics;
+}
+
+QFontMetricsF DecorationSettingsPrivate::cachedFontMetrics(qreal scale) const
+{
+    QMutexLocker locker(&d->fontMutex);
+    for (const auto &[cachedScale, metrics] : std::as_const(d->scaledFontMetrics)) {
+        if (cachedScale == scale) {
+            return metrics;
+        }
+    }
+    const quint64 generation = d->fontGeneration;
+    QFont scaledFont;
+    if (d->font) {
+        scaledFont = *d->font;
+    } else {
+        locker.unlock();
+        scaledFont = cachedFont();
+        locker.relock();
+    }
+    if (scaledFont.pixelSize() > 0) {
+        scaledFont.setPixelSize(qRound(scaledFont.pixelSize() * scale));
+    } else {
+        scaledFont.setPointSizeF(scaledFont.pointSizeF() * scale);
+    }
+    const QFontMetricsF metrics(scaledFont);
+    // metrics of a font which changed meanwhile must not end up in the cleared cache
+    if (generation == d->fontGeneration) {
+        d->scaledFontMetrics.append(std::make_pair(scale, metrics));
+    }
+    return metrics;
+}
+
+void DecorationSettingsPrivate::invalidateFontCache()
+{
+    QMutexLocker locker(&d->fontMutex);
+    d->fontGeneration++;
+    d->font.reset();
+    d->fontMetrics.reset();
+    d->scaledFontMetrics.clear();
+}
+
 DecorationSettingsPrivateV2::DecorationSettingsPrivateV2(DecorationSettings *parent)
     : DecorationSettingsPrivate(parent)
 {
@@ -50,6 +50,17 @@ public:
     void setLargeSpacing(int spacing);
     void setSmallSpacing(int spacing);
 
+    /**
+     * The font and its metrics as returned by font() and fontMetrics(), cached until
+     * invalidateFontCache() gets called. The metrics for a @p scale are the metrics of the
+     * font rendered at that scale, in device pixels. They are thread-safe, font() and
+     * fontMetrics() are invoked without holding the lock of the cache.
+     **/
+    QFont cachedFont() const;
+    QFontMetricsF cachedFontMetrics() const;
+    QFontMetricsF cachedFontMetrics(qreal scale) const;
+    void invalidateFontCache();
+
 protected:
     explicit DecorationSettingsPrivate(DecorationSettings *parent);
 
@@ -5,10 +5,16 @@
  */
 #pragma once
 
+#include "decorationdefines.h"
+
+#include <QMarginsF>
 #include <QPointF>
 #include <QRectF>
 #include <QSizeF>
 
+#include <cmath>
+#include <span>
+
 namespace KDecoration3
 {
 
@@ -21,6 +27,89 @@ inline qreal pixelSize(qreal scale)
     return 1.0 / scale;
 }
 
+/**
+ * snaps the logical geometry value to a fractional logical geometry value
+ * that aligns to the pixel grid of the integral scale @p Scale
+ *
+ * Unlike the variant taking the scale as argument it can be evaluated at compile time.
+ * It rounds with integer arithmetic, the result is exact if @p Scale is a power of two.
+ * @since 6.8
+ */
+template<int Scale>
+constexpr qreal snapToPixelGrid(qreal value)
+{
+    static_assert(Scale > 0, "the scale must be positive");
+    const qreal scaled = value * Scale;
+    // from 2^52 on every value is integral, this also keeps NaN and infinity out of the cast
+    if (!(scaled > -0x1p52 && scaled < 0x1p52)) {
+        return scaled / Scale;
+    }
+    // std::round is not constexpr, round half away from zero like it does
+    qint64 rounded = qint64(scaled);
+    const qreal fraction = scaled - rounded;
+    if (fraction >= 0.5) {
+        ++rounded;
+    } else if (fraction <= -0.5) {
+        --rounded;
+    }
+    if (rounded == 0 && scaled < 0) {
+        // std::round keeps the sign
+        return -0.0;
+    }
+    if constexpr (Scale == 1) {
+        return qreal(rounded);
+    } else {
+        return qreal(rounded) / Scale;
+    }
+}
+
+/**
+ * snaps the logical geometry value to a fractional logical geometry value
+ * that aligns to the pixel grid of the integral scale @p Scale
+ * @since 6.8
+ */
+template<int Scale>
+constexpr QPointF snapToPixelGrid(const QPointF &value)
+{
+    return QPointF(snapToPixelGrid<Scale>(value.x()), snapToPixelGrid<Scale>(value.y()));
+}
+
+/**
+ * snaps the logical geometry value to a fractional logical geometry value
+ * that aligns to the pixel grid of the integral scale @p Scale
+ * @since 6.8
+ */
+template<int Scale>
+constexpr QSizeF snapToPixelGrid(const QSizeF &value)
+{
+    return QSizeF(snapToPixelGrid<Scale>(value.width()), snapToPixelGrid<Scale>(value.height()));
+}
+
+/**
+ * snaps the logical geometry value to a fractional logical geometry value
+ * that aligns to the pixel grid of the integral scale @p Scale
+ * @since 6.8
+ */
+template<int Scale>
+constexpr QRectF snapToPixelGrid(const QRectF &value)
+{
+    return QRectF(snapToPixelGrid<Scale>(value.topLeft()), snapToPixelGrid<Scale>(value.bottomRight()));
+}
+
+/**
+ * snaps the logical geometry value to a fractional logical geometry value
+ * that aligns to the pixel grid of the integral scale @p Scale
+ * @since 6.8
+ */
+template<int Scale>
+constexpr QMarginsF snapToPixelGrid(const QMarginsF &value)
+{
+    return QMarginsF(snapToPixelGrid<Scale>(value.left()),
+                     snapToPixelGrid<Scale>(value.top()),
+                     snapToPixelGrid<Scale>(value.right()),
+                     snapToPixelGrid<Scale>(value.bottom()));
+}
+
 /**
  * snaps the logical geometry value to a fractional logical geometry value
  * that aligns to the pixel grid of the provided scale
@@ -28,6 +117,14 @@ inline qreal pixelSize(qreal scale)
  */
 inline qreal snapToPixelGrid(qreal value, qreal scale)
 {
+    // the most common scales are integral, they can be rounded with integer arithmetic
+    if (scale == 1.0) {
+        return snapToPixelGrid<1>(value);
+    } else if (scale == 2.0) {
+        return snapToPixelGrid<2>(value);
+    } else if (scale == 3.0) {
+        return snapToPixelGrid<3>(value);
+    }
     return std::round(value * scale) / scale;
 }
 
@@ -61,4 +158,117 @@ inline QRectF snapToPixelGrid(const QRectF &value, qreal scale)
     return QRectF(snapToPixelGrid(value.topLeft(), scale), snapToPixelGrid(value.bottomRight(), scale));
 }
 
+/**
+ * snaps the logical geometry value to a fractional logical geometry value
+ * that aligns to the pixel grid of the provided scale
+ * @since 6.8
+ */
+inline QMarginsF snapToPixelGrid(const QMarginsF &value, qreal scale)
+{
+    return QMarginsF(snapToPixelGrid(value.left(), scale),
+                     snapToPixelGrid(value.top(), scale),
+                     snapToPixelGrid(value.right(), scale),
+                     snapToPixelGrid(value.bottom(), scale));
+}
+
+/**
+ * snaps the logical geometry value to a fractional logical geometry value
+ * that aligns to the pixel grid of the provided scale
+ * @since 6.8
+ */
+inline BorderRadius snapToPixelGrid(const BorderRadius &value, qreal scale)
+{
+    return BorderRadius(snapToPixelGrid(value.topLeft(), scale),
+                        snapToPixelGrid(value.topRight(), scale),
+                        snapToPixelGrid(value.bottomRight(), scale),
+                        snapToPixelGrid(value.bottomLeft(), scale));
+}
+
+/**
+ * snaps all logical geometry values in place to fractional logical geometry values
+ * that align to the pixel grid of the provided scale
+ *
+ * The batch variants multiply by the pixel size, which is computed once for all values, instead
+ * of dividing by the scale. If the scale is a power of two, the results are identical to the
+ * scalar variant, otherwise they can differ from it by up to two units in the last place.
+ * @since 6.8
+ */
+inline void snapToPixelGrid(std::span<qreal> values, qreal scale)
+{
+    const qreal pixel = pixelSize(scale);
+    for (qreal &value : values) {
+        value = std::round(value * scale) * pixel;
+    }
+}
+
+/**
+ * snaps the edges of rects stored in structure of arrays layout in place to fractional logical
+ * geometry values that align to the pixel grid of the provided scale
+ *
+ * All spans must have the same size. Each of them is a contiguous run of values, so unlike
+ * the variant for QRectF, which stores the rects as array of structs, the values of several rects
+ * get processed at once by the vector units.
+ * @since 6.8
+ */
+inline void snapToPixelGrid(std::span<qreal> lefts, std::span<qreal> tops, std::span<qreal> rights, std::span<qreal> bottoms, qreal scale)
+{
+    Q_ASSERT(tops.size() == lefts.size() && rights.size() == lefts.size() && bottoms.size() == lefts.size());
+    snapToPixelGrid(lefts, scale);
+    snapToPixelGrid(tops, scale);
+    snapToPixelGrid(rights, scale);
+    snapToPixelGrid(bottoms, scale);
+}
+
+/**
+ * snaps all logical geometry values in place to fractional logical geometry values
+ * that align to the pixel grid of the provided scale
+ *
+ * The four edges of a rect are snapped together, layout code with many rects can keep their
+ * edges in structure of arrays layout instead.
+ * @since 6.8
+ */
+inline void snapToPixelGrid(std::span<QRectF> values, qreal scale)
+{
+    const qreal pixel = pixelSize(scale);
+    for (QRectF &value : values) {
+        qreal edges[4] = {value.left(), value.top(), value.right(), value.bottom()};
+        for (qreal &edge : edges) {
+            edge = std::round(edge * scale) * pixel;
+        }
+        value = QRectF(QPointF(edges[0], edges[1]), QPointF(edges[2], edges[3]));
+    }
+}
+
+/**
+ * snaps all logical geometry values in place to fractional logical geometry values
+ * that align to the pixel grid of the provided scale
+ * @since 6.8
+ */
+inline void snapToPixelGrid(std::span<QMarginsF> values, qreal scale)
+{
+    const qreal pixel = pixelSize(scale);
+    for (QMarginsF &value : values) {
+        value = QMarginsF(std::round(value.left() * scale) * pixel,
+                          std::round(value.top() * scale) * pixel,
+                          std::round(value.right() * scale) * pixel,
+                          std::round(value.bottom() * scale) * pixel);
+    }
+}
+
+/**
+ * snaps all logical geometry values in place to fractional logical geometry values
+ * that align to the pixel grid of the provided scale
+ * @since 6.8
+ */
+inline void snapToPixelGrid(std::span<BorderRadius> values, qreal scale)
+{
+    const qreal pixel = pixelSize(scale);
+    for (BorderRadius &value : values) {
+        value = BorderRadius(std::round(value.topLeft() * scale) * pixel,
+                             std::round(value.topRight() * scale) * pixel,
+                             std::round(value.bottomRight() * scale) * pixel,
+                             std::round(value.bottomLeft() * scale) * pixel);
+    }
+}
+
 }